@@ -0,0 +1,259 @@
+#pragma once
+#include "ScalarLayout.h"
+#include "UBOMembers.h"
+
+/// Intro and Usage
+/// This header defines types for per instance (or per vertex) attribute streams in the client code
+/// Vertex attributes have none of the std140 alignment rules, each attribute just needs a format, an offset and a stride.
+/// So instance structs are packed tightly : a vec3 is 12 bytes, a mat3 is 36, a mat4 is 64, and nothing is rounded up to a vec4.
+///
+/// The vocabulary is the same as Std140.h (it is the scalar layout), and listing the members with UBO_MEMBERS
+/// generates the table of attribute descriptors (location, component count, type, offset, stride) at compile time,
+/// so the glVertexAttribPointer calls can never drift out of sync with the struct.
+/// Matrices and arrays take one location per column / element, as they do in GLSL.
+///
+/// Here's an example use case, matching
+///     layout (location=1) in mat4 objectMatrix;
+///     layout (location=5) in mat3 normalMatrix;
+
+/**
+struct InstanceData : public vertex_attrib::UBOStruct<>
+{
+    vertex_attrib::mat4 objectMatrix;   // locations 1-4, offset 0
+    vertex_attrib::mat3 normalMatrix;   // locations 5-7, offset 64
+
+    UBO_MEMBERS(InstanceData, objectMatrix, normalMatrix)
+};
+
+// sizeof(InstanceData) == 100, where std140 would need 112
+glBindBuffer(GL_ARRAY_BUFFER, instanceBuffer);
+vertex_attrib::enableAttributes<InstanceData>(1, 1);
+**/
+
+namespace vertex_attrib
+{
+    using scalar::float32_t;
+    using scalar::double64_t;
+    using scalar::int32_t;
+    using scalar::uint32_t;
+
+    using scalar::Vector;
+
+    using scalar::vec2;
+    using scalar::vec3;
+    using scalar::vec4;
+
+    using scalar::dvec2;
+    using scalar::dvec3;
+    using scalar::dvec4;
+
+    using scalar::ivec2;
+    using scalar::ivec3;
+    using scalar::ivec4;
+
+    using scalar::uvec2;
+    using scalar::uvec3;
+    using scalar::uvec4;
+
+    using scalar::Array;
+    using scalar::Matrix;
+
+    using scalar::mat2;
+    using scalar::mat3;
+    using scalar::mat4;
+
+    using scalar::mat2x3;
+    using scalar::mat2x4;
+
+    using scalar::mat3x2;
+    using scalar::mat3x4;
+
+    using scalar::mat4x2;
+    using scalar::mat4x3;
+
+    using scalar::dmat2;
+    using scalar::dmat3;
+    using scalar::dmat4;
+
+    using scalar::UBOStruct;
+
+    /// Which glVertexAttrib*Pointer an attribute needs
+    enum class AttributeFunction
+    {
+        Float,      // glVertexAttribPointer
+        Integer,    // glVertexAttribIPointer
+        Double      // glVertexAttribLPointer
+    };
+
+    /// Everything one glVertexAttrib*Pointer call needs
+    struct AttributeDescriptor
+    {
+        const char* name;
+        GLuint location;
+        GLint components;
+        GLenum type;
+        AttributeFunction function;
+        std::size_t offset;
+        GLsizei stride;
+    };
+
+    template <typename P>
+    struct AttributeType;
+
+    template <>
+    struct AttributeType<GLfloat>
+    {
+        static constexpr GLenum value = GL_FLOAT;
+        static constexpr AttributeFunction function = AttributeFunction::Float;
+    };
+
+    template <>
+    struct AttributeType<GLint>
+    {
+        static constexpr GLenum value = GL_INT;
+        static constexpr AttributeFunction function = AttributeFunction::Integer;
+    };
+
+    template <>
+    struct AttributeType<GLuint>
+    {
+        static constexpr GLenum value = GL_UNSIGNED_INT;
+        static constexpr AttributeFunction function = AttributeFunction::Integer;
+    };
+
+    template <>
+    struct AttributeType<GLdouble>
+    {
+        static constexpr GLenum value = GL_DOUBLE;
+        static constexpr AttributeFunction function = AttributeFunction::Double;
+    };
+
+    namespace detail
+    {
+        /// dvec3 and dvec4 take two locations, everything else takes one
+        template <typename T>
+        constexpr std::size_t locationsPerValue()
+        {
+            return (sizeof(typename std140::ComponentType<T>::type) == 8 && std140::ValueSize<T>::value > 16) ? 2 : 1;
+        }
+
+        template <typename T>
+        constexpr std::size_t locationCount()
+        {
+            typedef typename std140::UnwrapArrayElement<T>::type U;
+
+            if constexpr (std140::IsLeaf<U>::value)
+            {
+                return locationsPerValue<U>();
+            }
+            else
+            {
+                static_assert(std140::IsArray<U>::value, "vertex attributes can't be structs, only scalars, vectors, matrices and arrays of them");
+                return std140::ArrayTraits<U>::Length * locationCount<typename std140::ArrayTraits<U>::AlignedType>();
+            }
+        }
+
+        /// Descriptors appendDescriptors writes for T : one per scalar, vector and matrix column, however many locations each takes
+        template <typename T>
+        constexpr std::size_t attributeCount()
+        {
+            typedef typename std140::UnwrapArrayElement<T>::type U;
+
+            if constexpr (std140::IsLeaf<U>::value)
+            {
+                return 1;
+            }
+            else
+            {
+                return std140::ArrayTraits<U>::Length * attributeCount<typename std140::ArrayTraits<U>::AlignedType>();
+            }
+        }
+
+        template <typename T, typename Table>
+        constexpr void appendDescriptors(Table& table, std::size_t& count, GLuint& location, const char* name, std::size_t offset, GLsizei stride)
+        {
+            typedef typename std140::UnwrapArrayElement<T>::type U;
+
+            if constexpr (std140::IsLeaf<U>::value)
+            {
+                typedef typename std140::ComponentType<U>::type P;
+
+                table[count++] = AttributeDescriptor{ name, location, GLint(std140::ValueSize<U>::value / sizeof(P)),
+                    AttributeType<P>::value, AttributeType<P>::function, offset, stride };
+
+                location += GLuint(locationsPerValue<U>());
+            }
+            else
+            {
+                for (std::size_t i = 0; i < std140::ArrayTraits<U>::Length; i++)
+                {
+                    appendDescriptors<typename std140::ArrayTraits<U>::AlignedType>(table, count, location, name, offset + i * std140::ArrayTraits<U>::Stride, stride);
+                }
+            }
+        }
+    }
+
+    /// Number of attribute locations the whole struct takes
+    template <typename T>
+    constexpr std::size_t locationCount()
+    {
+        std::size_t count = 0;
+        std140::forEachMember<T>([&count](auto member) { count += detail::locationCount<typename decltype(member)::type>(); });
+        return count;
+    }
+
+    /// Number of glVertexAttrib*Pointer calls, one per location except for the second half of dvec3 / dvec4
+    template <typename T>
+    constexpr std::size_t attributeCount()
+    {
+        std::size_t count = 0;
+        std140::forEachMember<T>([&count](auto member)
+        {
+            count += detail::attributeCount<typename decltype(member)::type>();
+        });
+        return count;
+    }
+
+    /// The attribute table for T, with consecutive locations starting at baseLocation
+    template <typename T>
+    constexpr std::array<AttributeDescriptor, attributeCount<T>()> attributeDescriptors(GLuint baseLocation = 0)
+    {
+        std::array<AttributeDescriptor, attributeCount<T>()> table{};
+        std::size_t count = 0;
+        GLuint location = baseLocation;
+
+        std140::forEachMember<T>([&](auto member)
+        {
+            detail::appendDescriptors<typename decltype(member)::type>(table, count, location, member.name, member.offset, GLsizei(sizeof(T)));
+        });
+
+        return table;
+    }
+
+    /// Sets up the attributes of T from the buffer bound to GL_ARRAY_BUFFER, starting at byte offset baseOffset
+    /// divisor 0 is per vertex data, 1 is per instance
+    template <typename T>
+    void enableAttributes(GLuint baseLocation, GLuint divisor, std::size_t baseOffset = 0)
+    {
+        for (const AttributeDescriptor& attribute : attributeDescriptors<T>(baseLocation))
+        {
+            const void* pointer = reinterpret_cast<const void*>(baseOffset + attribute.offset);
+
+            switch (attribute.function)
+            {
+            case AttributeFunction::Float:
+                glVertexAttribPointer(attribute.location, attribute.components, attribute.type, GL_FALSE, attribute.stride, pointer);
+                break;
+            case AttributeFunction::Integer:
+                glVertexAttribIPointer(attribute.location, attribute.components, attribute.type, attribute.stride, pointer);
+                break;
+            case AttributeFunction::Double:
+                glVertexAttribLPointer(attribute.location, attribute.components, attribute.type, attribute.stride, pointer);
+                break;
+            }
+
+            glEnableVertexAttribArray(attribute.location);
+            glVertexAttribDivisor(attribute.location, divisor);
+        }
+    }
+}
@@ -0,0 +1,373 @@
+#pragma once
+#include "UBOMembers.h"
+#include <cstring>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/// Intro and Usage
+/// std140 blocks whose members aren't known until run time, eg. material parameters defined in content files.
+/// DynamicLayout is built from a schema of names, types and array lengths, and lays each member out as it is added,
+/// with the alignments VectorAlignment and ArrayAlignment give the static types :
+///     a scalar is aligned to its size, a vector by VectorAlignment, so a vec3 is aligned to 16 but only takes 12 bytes
+///     array elements and matrix columns are aligned to at least alignof(vec4), and strided by their size rounded up to that
+/// so a dvec3 array element or dmat3 column is aligned to 32, and DynamicLayout and the static types always agree.
+///
+/// Setting values goes through setters handed out once, when the schema is loaded. A setter is the member's offset and stride,
+/// checked against the C++ type it writes when it is made, so a set is a single copy into the block with no name lookup or layout walk.
+///
+/// Here's an example use case:
+
+/**
+// from a content file
+std140::DynamicLayout layout;
+layout.add("surfaceColor", "vec3");
+layout.add("roughness", "float");
+layout.add("weights", "float", 4);
+
+std::vector<unsigned char> block(layout.size());
+
+// once, when the material is loaded
+const auto surfaceColor = layout.setter<std140::vec3>("surfaceColor");
+const auto weights = layout.setter<std140::float32_t>("weights");
+
+// per frame
+surfaceColor.set(block.data(), { { 1.0f, 0.5f, 0.0f } });
+weights.set(block.data(), 2, 0.25f);
+**/
+
+namespace std140
+{
+    enum class DynamicComponent
+    {
+        Float,
+        Double,
+        Int,
+        Uint,
+        Bool
+    };
+
+    /// A scalar has 1 row and 1 column, a vector 1 column, a matrix 2 to 4 of each. rows == 0 marks an unknown type
+    struct DynamicType
+    {
+        DynamicComponent component;
+        int rows;
+        int columns;
+
+        constexpr bool valid() const { return rows != 0; }
+
+        constexpr bool operator==(const DynamicType& other) const
+        {
+            return component == other.component && rows == other.rows && columns == other.columns;
+        }
+    };
+
+    /// The type named by a GLSL type name, eg. "vec3", "uint", "dmat4x3". Invalid if the name isn't a scalar, vector or matrix
+    constexpr DynamicType dynamicType(std::string_view name)
+    {
+        DynamicType type{ DynamicComponent::Float, 1, 1 };
+
+        const std::string_view scalars[5] = { "float", "double", "int", "uint", "bool" };
+        for (int i = 0; i < 5; i++)
+        {
+            if (name == scalars[i])
+            {
+                type.component = DynamicComponent(i);
+                return type;
+            }
+        }
+
+        const char prefixes[5] = { '\0', 'd', 'i', 'u', 'b' };
+        for (int i = 1; i < 5; i++)
+        {
+            if (!name.empty() && name[0] == prefixes[i])
+            {
+                type.component = DynamicComponent(i);
+                name.remove_prefix(1);
+                break;
+            }
+        }
+
+        const auto dimension = [](char c) { return (c >= '2' && c <= '4') ? c - '0' : 0; };
+
+        if (name.size() == 4 && name.substr(0, 3) == "vec")
+        {
+            type.rows = dimension(name[3]);
+            return type;
+        }
+
+        const bool matrixComponent = type.component == DynamicComponent::Float || type.component == DynamicComponent::Double;
+
+        if (matrixComponent && name.size() == 4 && name.substr(0, 3) == "mat")
+        {
+            type.columns = dimension(name[3]);
+            type.rows = type.columns;
+            return type;
+        }
+
+        if (matrixComponent && name.size() == 6 && name.substr(0, 3) == "mat" && name[4] == 'x')
+        {
+            type.columns = dimension(name[3]);
+            type.rows = type.columns ? dimension(name[5]) : 0;
+            return type;
+        }
+
+        type.rows = 0;
+        return type;
+    }
+
+    /// The GLSL name of a valid type, the inverse of dynamicType(). Square matrices get the short name, "mat3" rather than "mat3x3"
+    inline std::string dynamicTypeName(DynamicType type)
+    {
+        const char* const scalars[5] = { "float", "double", "int", "uint", "bool" };
+        const char* const prefixes[5] = { "", "d", "i", "u", "b" };
+
+        if (type.columns > 1)
+        {
+            std::string name = std::string(prefixes[int(type.component)]) + "mat" + char('0' + type.columns);
+            return type.rows == type.columns ? name : name + "x" + char('0' + type.rows);
+        }
+
+        if (type.rows > 1)
+        {
+            return std::string(prefixes[int(type.component)]) + "vec" + char('0' + type.rows);
+        }
+
+        return scalars[int(type.component)];
+    }
+
+    namespace detail
+    {
+        template <typename P>
+        constexpr DynamicComponent dynamicComponent()
+        {
+            if constexpr (std::is_same<P, GLdouble>::value)
+            {
+                return DynamicComponent::Double;
+            }
+            else if constexpr (std::is_same<P, GLint>::value)
+            {
+                return DynamicComponent::Int;
+            }
+            else if constexpr (std::is_same<P, GLuint>::value)
+            {
+                return DynamicComponent::Uint;
+            }
+            else if constexpr (std::is_same<P, Bool32>::value)
+            {
+                return DynamicComponent::Bool;
+            }
+            else
+            {
+                return DynamicComponent::Float;
+            }
+        }
+
+        template <typename P>
+        constexpr std::size_t dynamicVectorAlignment(int components)
+        {
+            switch (components)
+            {
+            case 1:
+                return sizeof(P);
+            case 2:
+                return VectorAlignment<P, 2>::AlignmentValue;
+            case 3:
+                return VectorAlignment<P, 3>::AlignmentValue;
+            default:
+                return VectorAlignment<P, 4>::AlignmentValue;
+            }
+        }
+
+        constexpr std::size_t dynamicComponentSize(DynamicComponent component)
+        {
+            return component == DynamicComponent::Double ? sizeof(GLdouble) : sizeof(GLfloat);
+        }
+
+        /// Alignment of a scalar or vector of components
+        constexpr std::size_t dynamicVectorAlignment(DynamicComponent component, int components)
+        {
+            switch (component)
+            {
+            case DynamicComponent::Double:
+                return dynamicVectorAlignment<GLdouble>(components);
+            case DynamicComponent::Int:
+                return dynamicVectorAlignment<GLint>(components);
+            case DynamicComponent::Uint:
+                return dynamicVectorAlignment<GLuint>(components);
+            case DynamicComponent::Bool:
+                return dynamicVectorAlignment<Bool32>(components);
+            default:
+                return dynamicVectorAlignment<GLfloat>(components);
+            }
+        }
+
+        /// The ArrayAlignment rule, for array elements and matrix columns
+        constexpr std::size_t dynamicArrayAlignment(std::size_t alignment)
+        {
+            return alignment > alignof(vec4) ? alignment : alignof(vec4);
+        }
+
+        constexpr std::size_t dynamicRoundUp(std::size_t value, std::size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+    }
+
+    /// The DynamicType of a C++ scalar, vector or column major matrix type, invalid for anything else
+    template <typename T>
+    constexpr DynamicType dynamicTypeOf()
+    {
+        if constexpr (MatrixTraits<T>::IsMatrix)
+        {
+            return DynamicType{ detail::dynamicComponent<typename MatrixTraits<T>::Component>(), MatrixTraits<T>::ColumnMajor ? MatrixTraits<T>::Rows : 0, MatrixTraits<T>::Columns };
+        }
+        else if constexpr (IsVector<T>::value)
+        {
+            return DynamicType{ detail::dynamicComponent<typename T::value_type>(), int(T::length()), 1 };
+        }
+        else if constexpr (IsScalar<T>::value)
+        {
+            return DynamicType{ detail::dynamicComponent<T>(), 1, 1 };
+        }
+        else
+        {
+            return DynamicType{ DynamicComponent::Float, 0, 0 };
+        }
+    }
+
+    struct DynamicMember
+    {
+        std::string name;
+        DynamicType type;
+        std::size_t arrayLength;    // 0 if the member isn't an array
+        std::size_t offset;
+        std::size_t alignment;
+        std::size_t size;           // bytes the member spans, a vec3 leaves its last 4 to the next member
+        std::size_t arrayStride;    // 0 if the member isn't an array
+        std::size_t matrixStride;   // 0 if the member isn't a matrix
+    };
+
+    /// Writes one member, or one element of an array member, of a block laid out by a DynamicLayout
+    template <typename T>
+    class DynamicSetter
+    {
+    public:
+
+        DynamicSetter() = default;
+
+        DynamicSetter(std::size_t offset, std::size_t stride) : offset(offset), stride(stride)
+        {
+        }
+
+        /// False if the member didn't exist or isn't a T
+        bool valid() const { return offset != std::size_t(-1); }
+
+        void set(void* block, const T& value) const
+        {
+            std::memcpy(static_cast<unsigned char*>(block) + offset, &value, Bytes);
+        }
+
+        void set(void* block, std::size_t index, const T& value) const
+        {
+            std::memcpy(static_cast<unsigned char*>(block) + offset + index * stride, &value, Bytes);
+        }
+
+    private:
+
+        // the values only, so a vec3 doesn't touch the member packed into its tail
+        static constexpr std::size_t Bytes = MatrixTraits<T>::IsMatrix ? sizeof(T) : ValueSize<T>::value;
+
+        std::size_t offset = std::size_t(-1);
+        std::size_t stride = 0;
+    };
+
+    class DynamicLayout
+    {
+    public:
+
+        static constexpr std::size_t npos = std::size_t(-1);
+
+        /// Appends a member after the ones already added and returns its index, or npos if the type is invalid
+        std::size_t add(const std::string& name, DynamicType type, std::size_t arrayLength = 0)
+        {
+            if (!type.valid())
+            {
+                return npos;
+            }
+
+            const std::size_t componentSize = detail::dynamicComponentSize(type.component);
+
+            DynamicMember member{ name, type, arrayLength, 0, 0, 0, 0, 0 };
+
+            std::size_t valueSize = componentSize * type.rows;
+            member.alignment = detail::dynamicVectorAlignment(type.component, type.rows);
+
+            if (type.columns > 1)
+            {
+                member.alignment = detail::dynamicArrayAlignment(member.alignment);
+                member.matrixStride = detail::dynamicRoundUp(valueSize, member.alignment);
+                valueSize = member.matrixStride * type.columns;
+            }
+
+            if (arrayLength)
+            {
+                member.alignment = detail::dynamicArrayAlignment(member.alignment);
+                member.arrayStride = detail::dynamicRoundUp(valueSize, member.alignment);
+                member.size = member.arrayStride * arrayLength;
+            }
+            else
+            {
+                member.size = valueSize;
+            }
+
+            member.offset = detail::dynamicRoundUp(end, member.alignment);
+            end = member.offset + member.size;
+
+            layoutMembers.push_back(member);
+            return layoutMembers.size() - 1;
+        }
+
+        /// Appends a member by GLSL type name, eg. add("weights", "float", 4)
+        std::size_t add(const std::string& name, std::string_view glslType, std::size_t arrayLength = 0)
+        {
+            return add(name, dynamicType(glslType), arrayLength);
+        }
+
+        /// Bytes to allocate for the block, the end of the last member
+        std::size_t size() const { return end; }
+
+        const std::vector<DynamicMember>& members() const { return layoutMembers; }
+
+        std::size_t find(std::string_view name) const
+        {
+            for (std::size_t i = 0; i < layoutMembers.size(); i++)
+            {
+                if (layoutMembers[i].name == name)
+                {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        /// A setter for the member called name, which must be a T or an array of T. Check valid() on the result
+        template <typename T>
+        DynamicSetter<T> setter(std::string_view name) const
+        {
+            const std::size_t i = find(name);
+
+            if (i == npos || !(layoutMembers[i].type == dynamicTypeOf<T>()))
+            {
+                return DynamicSetter<T>();
+            }
+
+            return DynamicSetter<T>(layoutMembers[i].offset, layoutMembers[i].arrayStride);
+        }
+
+    private:
+
+        std::vector<DynamicMember> layoutMembers;
+        std::size_t end = 0;
+    };
+}
@@ -0,0 +1,1136 @@
+#pragma once
+#include "UBOReflection.h"
+#include <string_view>
+
+/// Intro and Usage
+/// A constexpr parser for the struct and interface block declarations of a GLSL source string.
+/// It computes the std140 (and std430) offsets of every block member the way the spec lays them out,
+/// so the C++ structs can be checked against the shader with static_assert, and a layout mismatch fails the build
+/// instead of showing up in glGetActiveUniformsiv at startup.
+///
+/// What it understands :
+///     struct declarations, and layout(std140 / std430, row_major / column_major) uniform and buffer blocks, with an optional instance name
+///     default layout statements, layout(std140) uniform; and layout(std430, row_major) buffer; for the blocks that follow them
+///     scalar, vector and matrix types, struct types, one dimensional arrays sized with a literal or a #define, and unsized trailing arrays
+///     #define NAME <integer>, which are also exposed through define()
+/// Everything else (functions, in / out / loose uniforms, precision statements, other preprocessor lines) is skipped.
+/// The preprocessor isn't run, so #ifdef'd declarations are all parsed.
+///
+/// Parsing stops at the first thing it doesn't understand and records it in error and errorLine, so static_assert on ok() first.
+///
+/// Here's an example use case:
+
+/**
+constexpr char lightShader[] = R"(
+    struct PointLight { vec3 location; vec3 color; };
+    #define MAX_POINT_LIGHTS 25
+    layout(std140) uniform PointLightBlock { int nPointLights; PointLight pointLights[MAX_POINT_LIGHTS]; };
+)";
+
+constexpr std140::GlslShader lightLayout = std140::parseGlsl(lightShader);
+
+static_assert(lightLayout.ok(), "");
+static_assert(lightLayout.offsetOf("PointLightBlock", "pointLights[1].color") == 64, "");
+static_assert(std140::layoutMatches<PointLightUBO>(lightLayout, "PointLightBlock"), "PointLightUBO is out of date with the shader");
+**/
+
+namespace std140
+{
+    enum class GlslLayout
+    {
+        Std140,
+        Std430,
+        Other       // shared, packed or no layout qualifier, the offsets are up to the implementation
+    };
+
+    enum class GlslTypeKind
+    {
+        Scalar,
+        Vector,
+        Matrix,
+        Struct
+    };
+
+    struct GlslType
+    {
+        GlslTypeKind kind;
+        std::size_t componentSize;
+        int columns;                // components of a vector, columns of a matrix
+        int rows;
+        std::size_t structIndex;
+    };
+
+    struct GlslField
+    {
+        std::string_view name;
+        std::string_view typeName;
+        GlslType type;
+        std::size_t arrayLength;    // 0 if not an array
+        std::string_view arrayLengthName;   // the #define the length was given with, if any
+        bool runtimeSized;          // the unsized last member of a buffer block
+        bool rowMajor;
+        std::size_t offset[2];      // std140, std430
+    };
+
+    struct GlslStruct
+    {
+        std::string_view name;
+        std::size_t firstField;
+        std::size_t fieldCount;
+        std::size_t alignment[2];
+        std::size_t size[2];
+        bool defaultMajorness;      // holds a matrix without its own row_major / column_major, which GLSL lets an enclosing qualifier override
+    };
+
+    struct GlslBlock
+    {
+        std::string_view name;
+        std::string_view instanceName;
+        GlslLayout layout;
+        bool buffer;
+        std::size_t firstField;
+        std::size_t fieldCount;
+        std::size_t size;
+    };
+
+    struct GlslDefine
+    {
+        std::string_view name;
+        long long value;
+    };
+
+    /// The parsed declarations, in fixed capacity arrays so the whole thing can be a constexpr value
+    template <std::size_t MAX_FIELDS, std::size_t MAX_STRUCTS, std::size_t MAX_BLOCKS, std::size_t MAX_DEFINES>
+    struct BasicGlslShader
+    {
+        static constexpr std::size_t npos = std::size_t(-1);
+
+        std::array<GlslField, MAX_FIELDS> fields{};
+        std::array<GlslStruct, MAX_STRUCTS> structs{};
+        std::array<GlslBlock, MAX_BLOCKS> blocks{};
+        std::array<GlslDefine, MAX_DEFINES> defines{};
+
+        std::size_t fieldCount = 0;
+        std::size_t structCount = 0;
+        std::size_t blockCount = 0;
+        std::size_t defineCount = 0;
+
+        const char* error = nullptr;
+        std::size_t errorLine = 0;
+
+        constexpr bool ok() const { return error == nullptr; }
+
+        constexpr std::size_t structIndex(std::string_view name) const
+        {
+            for (std::size_t i = 0; i < structCount; i++)
+            {
+                if (structs[i].name == name)
+                {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        /// Looks a block up by block name or instance name
+        constexpr std::size_t blockIndex(std::string_view name) const
+        {
+            for (std::size_t i = 0; i < blockCount; i++)
+            {
+                if (blocks[i].name == name || (!blocks[i].instanceName.empty() && blocks[i].instanceName == name))
+                {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        constexpr long long define(std::string_view name) const
+        {
+            for (std::size_t i = 0; i < defineCount; i++)
+            {
+                if (defines[i].name == name)
+                {
+                    return defines[i].value;
+                }
+            }
+            return 0;
+        }
+
+        constexpr bool isDefined(std::string_view name) const
+        {
+            for (std::size_t i = 0; i < defineCount; i++)
+            {
+                if (defines[i].name == name)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+
+        static constexpr std::size_t roundUp(std::size_t value, std::size_t alignment)
+        {
+            return (value + alignment - 1) / alignment * alignment;
+        }
+
+        /// Base alignment and size of a value of type, without any array. L is 0 for std140, 1 for std430
+        constexpr std::size_t typeAlignment(const GlslType& type, bool rowMajor, int L) const
+        {
+            switch (type.kind)
+            {
+            case GlslTypeKind::Scalar:
+                return type.componentSize;
+            case GlslTypeKind::Vector:
+                return type.componentSize * (type.columns == 3 ? 4 : type.columns);
+            case GlslTypeKind::Matrix:
+                return matrixStride(type, rowMajor, L);
+            default:
+                return structs[type.structIndex].alignment[L];
+            }
+        }
+
+        constexpr std::size_t typeSize(const GlslType& type, bool rowMajor, int L) const
+        {
+            switch (type.kind)
+            {
+            case GlslTypeKind::Scalar:
+                return type.componentSize;
+            case GlslTypeKind::Vector:
+                return type.componentSize * type.columns;
+            case GlslTypeKind::Matrix:
+                return matrixStride(type, rowMajor, L) * (rowMajor ? type.rows : type.columns);
+            default:
+                return structs[type.structIndex].size[L];
+            }
+        }
+
+        /// A matrix is an array of its column (or row) vectors
+        constexpr std::size_t matrixStride(const GlslType& type, bool rowMajor, int L) const
+        {
+            const int length = rowMajor ? type.columns : type.rows;
+            const std::size_t vectorAlignment = type.componentSize * (length == 3 ? 4 : length);
+
+            return L == 0 ? roundUp(vectorAlignment, 16) : vectorAlignment;
+        }
+
+        constexpr std::size_t fieldAlignment(const GlslField& field, int L) const
+        {
+            const std::size_t alignment = typeAlignment(field.type, field.rowMajor, L);
+            return (L == 0 && (field.arrayLength || field.runtimeSized)) ? roundUp(alignment, 16) : alignment;
+        }
+
+        constexpr std::size_t arrayStride(const GlslField& field, int L) const
+        {
+            return roundUp(typeSize(field.type, field.rowMajor, L), fieldAlignment(field, L));
+        }
+
+        constexpr std::size_t fieldSize(const GlslField& field, int L) const
+        {
+            if (field.arrayLength || field.runtimeSized)
+            {
+                return arrayStride(field, L) * field.arrayLength;
+            }
+            return typeSize(field.type, field.rowMajor, L);
+        }
+
+        /// Byte offset of a member of a block, eg. offsetOf("PointLightBlock", "pointLights[1].color"), or npos if the path doesn't resolve
+        constexpr std::size_t offsetOf(std::string_view blockName, std::string_view path) const
+        {
+            const std::size_t b = blockIndex(blockName);
+            if (b == npos || blocks[b].layout == GlslLayout::Other)
+            {
+                return npos;
+            }
+
+            const int L = blocks[b].layout == GlslLayout::Std140 ? 0 : 1;
+
+            std::size_t first = blocks[b].firstField;
+            std::size_t count = blocks[b].fieldCount;
+            std::size_t offset = 0;
+            std::size_t i = 0;
+
+            while (true)
+            {
+                std::size_t end = i;
+                while (end < path.size() && path[end] != '.' && path[end] != '[')
+                {
+                    end++;
+                }
+
+                const std::string_view name = path.substr(i, end - i);
+
+                std::size_t f = npos;
+                for (std::size_t j = first; j < first + count; j++)
+                {
+                    if (fields[j].name == name)
+                    {
+                        f = j;
+                    }
+                }
+
+                if (f == npos)
+                {
+                    return npos;
+                }
+
+                offset += fields[f].offset[L];
+                i = end;
+
+                if (i < path.size() && path[i] == '[')
+                {
+                    std::size_t index = 0;
+                    for (i++; i < path.size() && path[i] != ']'; i++)
+                    {
+                        index = index * 10 + std::size_t(path[i] - '0');
+                    }
+                    i++;
+
+                    offset += index * arrayStride(fields[f], L);
+                }
+
+                if (i >= path.size())
+                {
+                    return offset;
+                }
+
+                if (path[i] != '.' || fields[f].type.kind != GlslTypeKind::Struct)
+                {
+                    return npos;
+                }
+
+                first = structs[fields[f].type.structIndex].firstField;
+                count = structs[fields[f].type.structIndex].fieldCount;
+                i++;
+            }
+        }
+    };
+
+    typedef BasicGlslShader<256, 32, 32, 32> GlslShader;
+
+    namespace detail
+    {
+        template <typename Shader>
+        class GlslParser
+        {
+        public:
+
+            constexpr GlslParser(std::string_view source, Shader& shader) : source(source), shader(shader)
+            {
+            }
+
+            constexpr void parse()
+            {
+                advance();
+
+                while (token.kind != TokenKind::End && shader.ok())
+                {
+                    topLevel();
+                }
+            }
+
+        private:
+
+            enum class TokenKind
+            {
+                End,
+                Identifier,
+                Number,
+                Symbol
+            };
+
+            struct Token
+            {
+                TokenKind kind;
+                std::string_view text;
+            };
+
+            std::string_view source;
+            Shader& shader;
+
+            std::size_t pos = 0;
+            std::size_t line = 1;
+            bool lineStart = true;
+            Token token{ TokenKind::End, std::string_view() };
+
+            // set by layout(...) uniform; and layout(...) buffer; statements
+            struct BlockDefaults
+            {
+                GlslLayout layout;
+                bool rowMajor;
+            };
+
+            BlockDefaults blockDefaults[2] = { { GlslLayout::Other, false }, { GlslLayout::Other, false } };     // uniform, buffer
+
+            static constexpr bool isIdentifierStart(char c)
+            {
+                return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c == '_';
+            }
+
+            static constexpr bool isDigit(char c)
+            {
+                return c >= '0' && c <= '9';
+            }
+
+            constexpr void fail(const char* message)
+            {
+                if (shader.ok())
+                {
+                    shader.error = message;
+                    shader.errorLine = line;
+                }
+
+                pos = source.size();
+                token = Token{ TokenKind::End, std::string_view() };
+            }
+
+            constexpr bool is(std::string_view text) const
+            {
+                return token.kind != TokenKind::End && token.text == text;
+            }
+
+            constexpr void expect(std::string_view text, const char* message)
+            {
+                if (!is(text))
+                {
+                    fail(message);
+                    return;
+                }
+                advance();
+            }
+
+            constexpr void skipLine()
+            {
+                while (pos < source.size() && source[pos] != '\n')
+                {
+                    // line continuation
+                    if (source[pos] == '\\' && pos + 1 < source.size() && source[pos + 1] == '\n')
+                    {
+                        pos++;
+                        line++;
+                    }
+                    pos++;
+                }
+            }
+
+            constexpr std::string_view lexWord()
+            {
+                const std::size_t start = pos;
+                while (pos < source.size() && (isIdentifierStart(source[pos]) || isDigit(source[pos])))
+                {
+                    pos++;
+                }
+                return source.substr(start, pos - start);
+            }
+
+            constexpr void skipHorizontalSpace()
+            {
+                while (pos < source.size() && (source[pos] == ' ' || source[pos] == '\t'))
+                {
+                    pos++;
+                }
+            }
+
+            static constexpr bool parseInteger(std::string_view text, long long& value)
+            {
+                value = 0;
+
+                if (text.size() > 2 && text[0] == '0' && (text[1] == 'x' || text[1] == 'X'))
+                {
+                    for (std::size_t i = 2; i < text.size(); i++)
+                    {
+                        const char c = text[i];
+                        if (isDigit(c))
+                        {
+                            value = value * 16 + (c - '0');
+                        }
+                        else if (c >= 'a' && c <= 'f')
+                        {
+                            value = value * 16 + (c - 'a' + 10);
+                        }
+                        else if (c >= 'A' && c <= 'F')
+                        {
+                            value = value * 16 + (c - 'A' + 10);
+                        }
+                        else if (!(c == 'u' || c == 'U') || i + 1 != text.size())
+                        {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+
+                for (std::size_t i = 0; i < text.size(); i++)
+                {
+                    if (isDigit(text[i]))
+                    {
+                        value = value * 10 + (text[i] - '0');
+                    }
+                    else if (!(text[i] == 'u' || text[i] == 'U') || i + 1 != text.size() || i == 0)
+                    {
+                        return false;
+                    }
+                }
+
+                return !text.empty();
+            }
+
+            /// Records #define NAME <integer>, everything else on a preprocessor line is ignored
+            constexpr void directive()
+            {
+                pos++;
+                skipHorizontalSpace();
+
+                if (lexWord() == "define")
+                {
+                    skipHorizontalSpace();
+                    const std::string_view name = lexWord();
+                    skipHorizontalSpace();
+
+                    const std::size_t start = pos;
+                    while (pos < source.size() && (isDigit(source[pos]) || isIdentifierStart(source[pos])))
+                    {
+                        pos++;
+                    }
+
+                    long long value = 0;
+                    if (!name.empty() && parseInteger(source.substr(start, pos - start), value))
+                    {
+                        if (shader.defineCount == shader.defines.size())
+                        {
+                            fail("too many #defines, raise the capacity of BasicGlslShader");
+                            return;
+                        }
+                        shader.defines[shader.defineCount++] = GlslDefine{ name, value };
+                    }
+                }
+
+                skipLine();
+            }
+
+            constexpr void skipSpace()
+            {
+                while (pos < source.size())
+                {
+                    const char c = source[pos];
+
+                    if (c == ' ' || c == '\t' || c == '\r')
+                    {
+                        pos++;
+                    }
+                    else if (c == '\n')
+                    {
+                        pos++;
+                        line++;
+                        lineStart = true;
+                    }
+                    else if (c == '/' && pos + 1 < source.size() && source[pos + 1] == '/')
+                    {
+                        skipLine();
+                    }
+                    else if (c == '/' && pos + 1 < source.size() && source[pos + 1] == '*')
+                    {
+                        pos += 2;
+                        while (pos + 1 < source.size() && !(source[pos] == '*' && source[pos + 1] == '/'))
+                        {
+                            line += source[pos] == '\n' ? 1 : 0;
+                            pos++;
+                        }
+                        pos += 2;
+                    }
+                    else if (c == '#' && lineStart)
+                    {
+                        directive();
+                    }
+                    else
+                    {
+                        return;
+                    }
+                }
+            }
+
+            constexpr void advance()
+            {
+                skipSpace();
+                lineStart = false;
+
+                if (pos >= source.size())
+                {
+                    pos = source.size();
+                    token = Token{ TokenKind::End, std::string_view() };
+                    return;
+                }
+
+                const std::size_t start = pos;
+                const char c = source[pos];
+
+                if (isIdentifierStart(c))
+                {
+                    token = Token{ TokenKind::Identifier, lexWord() };
+                }
+                else if (isDigit(c))
+                {
+                    while (pos < source.size() && (isDigit(source[pos]) || isIdentifierStart(source[pos]) || source[pos] == '.'))
+                    {
+                        pos++;
+                    }
+                    token = Token{ TokenKind::Number, source.substr(start, pos - start) };
+                }
+                else
+                {
+                    pos++;
+                    token = Token{ TokenKind::Symbol, source.substr(start, 1) };
+                }
+            }
+
+            /// Skips a declaration or function we don't care about, up to its ';' or the end of its body
+            constexpr void skipStatement()
+            {
+                while (token.kind != TokenKind::End)
+                {
+                    if (is(";"))
+                    {
+                        advance();
+                        return;
+                    }
+
+                    if (is("{"))
+                    {
+                        int depth = 0;
+                        do
+                        {
+                            depth += is("{") ? 1 : is("}") ? -1 : 0;
+                            advance();
+                        } while (depth > 0 && token.kind != TokenKind::End);
+
+                        // an initializer list is followed by its ';', a function body isn't
+                        if (is(";"))
+                        {
+                            advance();
+                        }
+                        return;
+                    }
+
+                    advance();
+                }
+            }
+
+            /// packing and majorness are set if the list gave a layout and a majorness
+            constexpr void layoutQualifiers(GlslLayout& layout, bool& packing, bool& rowMajor, bool& majorness)
+            {
+                advance();
+                expect("(", "expected ( after layout");
+
+                while (!is(")") && token.kind != TokenKind::End)
+                {
+                    if (is("std140"))
+                    {
+                        layout = GlslLayout::Std140;
+                        packing = true;
+                    }
+                    else if (is("std430"))
+                    {
+                        layout = GlslLayout::Std430;
+                        packing = true;
+                    }
+                    else if (is("shared") || is("packed"))
+                    {
+                        layout = GlslLayout::Other;
+                        packing = true;
+                    }
+                    else if (is("row_major"))
+                    {
+                        rowMajor = true;
+                        majorness = true;
+                    }
+                    else if (is("column_major"))
+                    {
+                        rowMajor = false;
+                        majorness = true;
+                    }
+                    advance();
+                }
+
+                expect(")", "expected ) closing the layout qualifiers");
+            }
+
+            constexpr bool isMemberQualifier() const
+            {
+                constexpr std::string_view qualifiers[] =
+                {
+                    "highp", "mediump", "lowp", "precise", "invariant", "flat", "smooth", "noperspective", "centroid",
+                    "coherent", "volatile", "restrict", "readonly", "writeonly", "const"
+                };
+
+                for (std::string_view qualifier : qualifiers)
+                {
+                    if (is(qualifier))
+                    {
+                        return true;
+                    }
+                }
+                return false;
+            }
+
+            static constexpr int digitAt(std::string_view text, std::size_t i)
+            {
+                return (i < text.size() && text[i] >= '2' && text[i] <= '4') ? text[i] - '0' : 0;
+            }
+
+            constexpr bool builtinType(std::string_view text, GlslType& type) const
+            {
+                type = GlslType{ GlslTypeKind::Scalar, 4, 1, 1, 0 };
+
+                if (text == "float" || text == "int" || text == "uint" || text == "bool")
+                {
+                    return true;
+                }
+
+                if (text == "double")
+                {
+                    type.componentSize = 8;
+                    return true;
+                }
+
+                std::size_t i = 0;
+
+                if (text[0] == 'd' && text.size() > 1 && (text[1] == 'v' || text[1] == 'm'))
+                {
+                    type.componentSize = 8;
+                    i = 1;
+                }
+                else if ((text[0] == 'i' || text[0] == 'u' || text[0] == 'b') && text.size() > 1 && text[1] == 'v')
+                {
+                    i = 1;
+                }
+
+                if (text.substr(i, 3) == "vec" && text.size() == i + 4 && digitAt(text, i + 3))
+                {
+                    type.kind = GlslTypeKind::Vector;
+                    type.columns = digitAt(text, i + 3);
+                    return true;
+                }
+
+                if (text.substr(i, 3) == "mat" && (i == 0 || type.componentSize == 8) && digitAt(text, i + 3))
+                {
+                    type.kind = GlslTypeKind::Matrix;
+                    type.columns = digitAt(text, i + 3);
+
+                    if (text.size() == i + 4)
+                    {
+                        type.rows = type.columns;
+                        return true;
+                    }
+
+                    if (text.size() == i + 6 && text[i + 4] == 'x' && digitAt(text, i + 5))
+                    {
+                        type.rows = digitAt(text, i + 5);
+                        return true;
+                    }
+                }
+
+                return false;
+            }
+
+            constexpr std::size_t arrayLength(bool& runtimeSized, std::string_view& lengthName)
+            {
+                runtimeSized = false;
+                lengthName = std::string_view();
+
+                if (!is("["))
+                {
+                    return 0;
+                }
+
+                advance();
+
+                if (is("]"))
+                {
+                    runtimeSized = true;
+                    advance();
+                    return 0;
+                }
+
+                long long length = 0;
+
+                if (token.kind == TokenKind::Number)
+                {
+                    if (!parseInteger(token.text, length))
+                    {
+                        fail("array length is not an integer");
+                        return 0;
+                    }
+                }
+                else if (shader.isDefined(token.text))
+                {
+                    length = shader.define(token.text);
+                    lengthName = token.text;
+                }
+                else
+                {
+                    fail("array length must be an integer literal or a #define of one");
+                    return 0;
+                }
+
+                advance();
+                expect("]", "expected ] after the array length");
+
+                if (is("["))
+                {
+                    fail("arrays of arrays aren't supported");
+                }
+
+                return std::size_t(length);
+            }
+
+            /// Parses member declarations up to the closing }. Returns true if a matrix member took its majorness from blockRowMajor
+            constexpr bool members(bool blockRowMajor)
+            {
+                bool defaultMajorness = false;
+
+                while (!is("}") && token.kind != TokenKind::End)
+                {
+                    bool rowMajor = blockRowMajor;
+                    bool explicitMajorness = false;
+                    GlslLayout ignored = GlslLayout::Other;
+                    bool ignoredPacking = false;
+
+                    while (is("layout") || isMemberQualifier())
+                    {
+                        if (is("layout"))
+                        {
+                            layoutQualifiers(ignored, ignoredPacking, rowMajor, explicitMajorness);
+                        }
+                        else
+                        {
+                            advance();
+                        }
+                    }
+
+                    GlslType type{};
+                    const std::string_view typeName = token.text;
+
+                    if (token.kind != TokenKind::Identifier)
+                    {
+                        fail("expected a member type");
+                        return false;
+                    }
+
+                    if (!builtinType(typeName, type))
+                    {
+                        const std::size_t s = shader.structIndex(typeName);
+                        if (s == Shader::npos)
+                        {
+                            fail("unknown member type, structs must be declared before they are used");
+                            return false;
+                        }
+                        type = GlslType{ GlslTypeKind::Struct, 0, 0, 0, s };
+
+                        // struct layouts are worked out once, with their matrices column major unless qualified inside the struct
+                        if (rowMajor && shader.structs[s].defaultMajorness)
+                        {
+                            fail("row_major on a struct member isn't supported for structs with unqualified matrices, qualify the matrices inside the struct");
+                            return false;
+                        }
+
+                        defaultMajorness = defaultMajorness || shader.structs[s].defaultMajorness;
+                    }
+                    else if (type.kind == GlslTypeKind::Matrix && !explicitMajorness)
+                    {
+                        defaultMajorness = true;
+                    }
+
+                    advance();
+
+                    while (token.kind == TokenKind::Identifier)
+                    {
+                        GlslField field{ token.text, typeName, type, 0, std::string_view(), false, rowMajor, { 0, 0 } };
+
+                        advance();
+                        field.arrayLength = arrayLength(field.runtimeSized, field.arrayLengthName);
+
+                        if (shader.fieldCount == shader.fields.size())
+                        {
+                            fail("too many members, raise the capacity of BasicGlslShader");
+                            return false;
+                        }
+                        shader.fields[shader.fieldCount++] = field;
+
+                        if (!is(","))
+                        {
+                            break;
+                        }
+                        advance();
+                    }
+
+                    expect(";", "expected ; after a member declaration");
+                }
+
+                return defaultMajorness;
+            }
+
+            /// Assigns offsets to fields [first, first + count) with the std140 (L = 0) or std430 (L = 1) rules, returns the end of the last one
+            constexpr std::size_t layoutFields(std::size_t first, std::size_t count, int L, std::size_t& maxAlignment)
+            {
+                std::size_t offset = 0;
+                maxAlignment = 1;
+
+                for (std::size_t i = first; i < first + count; i++)
+                {
+                    GlslField& field = shader.fields[i];
+                    const std::size_t alignment = shader.fieldAlignment(field, L);
+
+                    offset = Shader::roundUp(offset, alignment);
+                    field.offset[L] = offset;
+                    offset += shader.fieldSize(field, L);
+
+                    maxAlignment = alignment > maxAlignment ? alignment : maxAlignment;
+                }
+
+                return offset;
+            }
+
+            constexpr void structDeclaration()
+            {
+                advance();
+
+                if (token.kind != TokenKind::Identifier)
+                {
+                    fail("expected a struct name");
+                    return;
+                }
+
+                GlslStruct decl{ token.text, shader.fieldCount, 0, { 0, 0 }, { 0, 0 }, false };
+
+                advance();
+                expect("{", "expected { after the struct name");
+                decl.defaultMajorness = members(false);
+                expect("}", "expected } closing the struct");
+
+                decl.fieldCount = shader.fieldCount - decl.firstField;
+
+                for (int L = 0; L < 2; L++)
+                {
+                    std::size_t maxAlignment = 1;
+                    const std::size_t end = layoutFields(decl.firstField, decl.fieldCount, L, maxAlignment);
+
+                    decl.alignment[L] = L == 0 ? Shader::roundUp(maxAlignment, 16) : maxAlignment;
+                    decl.size[L] = Shader::roundUp(end, decl.alignment[L]);
+                }
+
+                if (shader.structCount == shader.structs.size())
+                {
+                    fail("too many structs, raise the capacity of BasicGlslShader");
+                    return;
+                }
+                shader.structs[shader.structCount++] = decl;
+
+                skipStatement();
+            }
+
+            /// uniform or buffer, with the layout already parsed. packing and majorness say which of layout and rowMajor it gave,
+            /// the rest come from the defaults. layout(...) uniform; and layout(...) buffer; set the defaults for the blocks after them.
+            /// Loose uniforms and other declarations are skipped
+            constexpr void blockOrDeclaration(GlslLayout layout, bool packing, bool rowMajor, bool majorness)
+            {
+                while (isMemberQualifier())
+                {
+                    advance();
+                }
+
+                if (!is("uniform") && !is("buffer"))
+                {
+                    skipStatement();
+                    return;
+                }
+
+                const bool buffer = is("buffer");
+                advance();
+
+                while (isMemberQualifier())
+                {
+                    advance();
+                }
+
+                BlockDefaults& defaults = blockDefaults[buffer ? 1 : 0];
+
+                if (is(";"))
+                {
+                    defaults.layout = packing ? layout : defaults.layout;
+                    defaults.rowMajor = majorness ? rowMajor : defaults.rowMajor;
+                    advance();
+                    return;
+                }
+
+                layout = packing ? layout : defaults.layout;
+                rowMajor = majorness ? rowMajor : defaults.rowMajor;
+
+                if (token.kind != TokenKind::Identifier)
+                {
+                    fail("expected a block name or ; after uniform or buffer");
+                    return;
+                }
+
+                const std::string_view name = token.text;
+                advance();
+
+                if (!is("{"))
+                {
+                    // a loose uniform, eg. uniform sampler2D tex;
+                    if (token.kind != TokenKind::Identifier)
+                    {
+                        fail("expected { or a uniform name");
+                        return;
+                    }
+
+                    skipStatement();
+                    return;
+                }
+
+                advance();
+
+                GlslBlock block{ name, std::string_view(), layout, buffer, shader.fieldCount, 0, 0 };
+
+                members(rowMajor);
+                expect("}", "expected } closing the block");
+
+                block.fieldCount = shader.fieldCount - block.firstField;
+
+                if (token.kind == TokenKind::Identifier)
+                {
+                    block.instanceName = token.text;
+                    advance();
+
+                    bool runtimeSized = false;
+                    std::string_view lengthName;
+                    arrayLength(runtimeSized, lengthName);
+                }
+
+                expect(";", "expected ; after the block");
+
+                if (layout != GlslLayout::Other)
+                {
+                    std::size_t maxAlignment = 1;
+                    block.size = layoutFields(block.firstField, block.fieldCount, layout == GlslLayout::Std140 ? 0 : 1, maxAlignment);
+                }
+
+                if (shader.blockCount == shader.blocks.size())
+                {
+                    fail("too many blocks, raise the capacity of BasicGlslShader");
+                    return;
+                }
+                shader.blocks[shader.blockCount++] = block;
+            }
+
+            constexpr void topLevel()
+            {
+                if (is("struct"))
+                {
+                    structDeclaration();
+                }
+                else if (is("layout"))
+                {
+                    GlslLayout layout = GlslLayout::Other;
+                    bool packing = false;
+                    bool rowMajor = false;
+                    bool majorness = false;
+
+                    layoutQualifiers(layout, packing, rowMajor, majorness);
+                    blockOrDeclaration(layout, packing, rowMajor, majorness);
+                }
+                else if (is("uniform") || is("buffer"))
+                {
+                    blockOrDeclaration(GlslLayout::Other, false, false, false);
+                }
+                else
+                {
+                    skipStatement();
+                }
+            }
+        };
+
+        template <typename T, typename Shader>
+        constexpr bool fieldsMatch(const Shader& shader, std::size_t first, std::size_t count, int L)
+        {
+            if (count != memberCount<T>())
+            {
+                return false;
+            }
+
+            bool matches = true;
+            std::size_t i = first;
+
+            forEachMember<T>([&](auto member)
+            {
+                typedef typename decltype(member)::type M;
+                typedef typename MemberType<M>::type E;
+
+                const MemberInfo info = detail::memberInfo<M>(member.name, member.offset);
+                const GlslField& field = shader.fields[i++];
+
+                matches = matches && field.name == std::string_view(info.name) && field.offset[L] == info.offset && field.arrayLength == info.arrayLength &&
+                    (info.arrayLength == 0 || shader.arrayStride(field, L) == info.arrayStride);
+
+                if constexpr (MatrixTraits<E>::IsMatrix)
+                {
+                    matches = matches && field.rowMajor == info.rowMajor && field.typeName == std::string_view(info.glslType);
+                }
+                else if constexpr (IsLeaf<E>::value)
+                {
+                    matches = matches && field.typeName == std::string_view(info.glslType);
+                }
+                else
+                {
+                    matches = matches && field.type.kind == GlslTypeKind::Struct &&
+                        fieldsMatch<E>(shader, shader.structs[field.type.structIndex].firstField, shader.structs[field.type.structIndex].fieldCount, L);
+                }
+            });
+
+            return matches;
+        }
+    }
+
+    /// Parses into an existing shader, eg. a large capacity one allocated on the heap by a tool
+    template <typename Shader>
+    constexpr void parseGlsl(std::string_view source, Shader& shader)
+    {
+        detail::GlslParser<Shader> parser(source, shader);
+        parser.parse();
+    }
+
+    template <typename Shader = GlslShader>
+    constexpr Shader parseGlsl(std::string_view source)
+    {
+        Shader shader{};
+        parseGlsl(source, shader);
+        return shader;
+    }
+
+    /// True if T (listed with UBO_MEMBERS) has the same member names, types, offsets and strides as the GLSL block or struct called name.
+    /// Blocks use their own layout, structs are compared with the std140 rules unless layout says otherwise.
+    /// For a buffer block ending in an unsized array, T can also be the RuntimeArray header holding the other members
+    template <typename T, typename Shader>
+    constexpr bool layoutMatches(const Shader& shader, std::string_view name, GlslLayout layout = GlslLayout::Std140)
+    {
+        const std::size_t b = shader.blockIndex(name);
+
+        if (b != Shader::npos)
+        {
+            const GlslBlock& block = shader.blocks[b];
+
+            // T can be the header of a RuntimeArray, without the unsized array
+            std::size_t count = block.fieldCount;
+            if (count && shader.fields[block.firstField + count - 1].runtimeSized && memberCount<T>() == count - 1)
+            {
+                count--;
+            }
+
+            return block.layout != GlslLayout::Other && detail::fieldsMatch<T>(shader, block.firstField, count, block.layout == GlslLayout::Std140 ? 0 : 1);
+        }
+
+        const std::size_t s = shader.structIndex(name);
+
+        return s != Shader::npos && layout != GlslLayout::Other &&
+            detail::fieldsMatch<T>(shader, shader.structs[s].firstField, shader.structs[s].fieldCount, layout == GlslLayout::Std140 ? 0 : 1);
+    }
+}
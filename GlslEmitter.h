@@ -0,0 +1,166 @@
+#pragma once
+#include "UBOReflection.h"
+#include <string>
+#include <vector>
+
+/// Intro and Usage
+/// The reverse of GlslBlockParser.h : the C++ struct is the source of truth and the GLSL block declaration is generated from its UBO_MEMBERS list.
+/// glslUniformBlock<T>() prints a layout(std140) uniform block with the members of T, preceded by the declarations of every struct it uses, dependencies first.
+/// Array<> members get their lengths, arrays of arrays all of them, and a Matrix<..., false> member is declared layout(row_major).
+/// Members can then be reordered or repacked in C++ alone, and the shader picks the change up the next time it is built.
+///
+/// Here's an example use case:
+
+/**
+struct PointLight : public std140::UBOStruct<>
+{
+    std140::vec3 location;
+    std140::vec3 color;
+
+    UBO_MEMBERS(PointLight, location, color)
+};
+
+struct PointLightUBO
+{
+    std140::int32_t nPointLights = 0;
+    std140::Array<PointLight, 25> pointLights;
+
+    UBO_MEMBERS(PointLightUBO, nPointLights, pointLights)
+};
+
+std::string source = "#version 410 core\n" + std140::glslUniformBlock<PointLightUBO>("PointLightBlock") + lightingCode;
+
+// struct PointLight
+// {
+//     vec3 location;
+//     vec3 color;
+// };
+//
+// layout(std140) uniform PointLightBlock
+// {
+//     int nPointLights;
+//     PointLight pointLights[25];
+// };
+**/
+
+namespace std140
+{
+    namespace detail
+    {
+        /// "[2][3]" for an Array<Array<P, 3>, 2>, empty for anything else
+        template <typename T>
+        std::string glslArraySuffix()
+        {
+            typedef typename UnwrapArrayElement<T>::type U;
+
+            if constexpr (IsArray<U>::value && !MatrixTraits<U>::IsMatrix)
+            {
+                return "[" + std::to_string(ArrayTraits<U>::Length) + "]" + glslArraySuffix<typename ArrayTraits<U>::AlignedType>();
+            }
+            else
+            {
+                return std::string();
+            }
+        }
+
+        /// One member declaration, with layout(row_major) for row major matrices. Column major is the GLSL default and isn't spelled out
+        template <typename M>
+        std::string glslMemberDeclaration(const char* name, const std::string& indent)
+        {
+            typedef typename MemberType<M>::type E;
+
+            std::string declaration = indent;
+
+            if constexpr (MatrixTraits<E>::IsMatrix)
+            {
+                if (!MatrixTraits<E>::ColumnMajor)
+                {
+                    declaration += "layout(row_major) ";
+                }
+            }
+
+            return declaration + glslTypeName<E>() + " " + name + glslArraySuffix<M>() + ";\n";
+        }
+
+        /// Appends the declaration of every struct type reachable from T, dependencies first
+        template <typename T>
+        void appendGlslStructs(std::vector<std::string>& done, std::string& glsl)
+        {
+            typedef typename MemberType<T>::type U;
+
+            if constexpr (!IsLeaf<U>::value && !MatrixTraits<U>::IsMatrix)
+            {
+                static_assert(HasMembers<U>::value, "list the members of nested structs with UBO_MEMBERS");
+
+                for (const std::string& name : done)
+                {
+                    if (name == U::uboName())
+                    {
+                        return;
+                    }
+                }
+
+                forEachMember<U>([&](auto member)
+                {
+                    appendGlslStructs<typename decltype(member)::type>(done, glsl);
+                });
+
+                done.push_back(U::uboName());
+
+                glsl += std::string("struct ") + U::uboName() + "\n{\n";
+
+                forEachMember<U>([&](auto member)
+                {
+                    glsl += glslMemberDeclaration<typename decltype(member)::type>(member.name, "    ");
+                });
+
+                glsl += "};\n\n";
+            }
+        }
+    }
+
+    /// GLSL declaring the struct types used by T, dependencies first, each once
+    template <typename T>
+    std::string glslStructDeclarations()
+    {
+        std::string glsl;
+        std::vector<std::string> done;
+
+        forEachMember<T>([&](auto member)
+        {
+            detail::appendGlslStructs<typename decltype(member)::type>(done, glsl);
+        });
+
+        return glsl;
+    }
+
+    /// GLSL declaring layout(<layout>) <storage> <blockName> { members of T } <instanceName>;
+    /// Pass declareStructs = false if the shader already declares the struct types, eg. when several blocks share them.
+    /// For std430 types, glslBlock<T>("Particles", "", "std430", "buffer") declares a shader storage block
+    template <typename T>
+    std::string glslBlock(const std::string& blockName, const std::string& instanceName = std::string(),
+        const std::string& layout = "std140", const std::string& storage = "uniform", bool declareStructs = true)
+    {
+        static_assert(HasMembers<T>::value, "list the members of the block with UBO_MEMBERS");
+
+        std::string glsl = declareStructs ? glslStructDeclarations<T>() : std::string();
+
+        glsl += "layout(" + layout + ") " + storage + " " + blockName + "\n{\n";
+
+        forEachMember<T>([&](auto member)
+        {
+            glsl += detail::glslMemberDeclaration<typename decltype(member)::type>(member.name, "    ");
+        });
+
+        glsl += "}" + (instanceName.empty() ? std::string() : " " + instanceName) + ";\n";
+
+        return glsl;
+    }
+
+    /// The layout(std140) uniform block for T
+    template <typename T>
+    std::string glslUniformBlock(const std::string& blockName, const std::string& instanceName = std::string(), bool declareStructs = true)
+    {
+        return glslBlock<T>(blockName, instanceName, "std140", "uniform", declareStructs);
+    }
+}
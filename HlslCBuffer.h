@@ -0,0 +1,246 @@
+#pragma once
+#include "Std140.h"
+
+/// Intro and Usage
+/// This header defines types you can use to declare HLSL constant buffers (cbuffer) with the legacy fxc packing rules in the client code
+/// This is the layout a GLSL uniform block ends up with when it is cross compiled to HLSL without packoffset annotations.
+/// It mirrors the vocabulary of Std140.h, so the same struct definition can be declared for both backends.
+///
+/// The cbuffer rules, compared to std140 :
+///     scalars and vectors are aligned to their component, but a vector may not straddle a 16 byte register boundary
+///     arrays, matrices and structs always start on a 16 byte register boundary
+///     array elements (and matrix columns) each start a new register, but the last element is NOT padded out
+///     structs are NOT padded out, so the next member can be packed into the tail of the last register
+///
+/// So a float followed by a float3 packs into one register (std140 needs two), and a float[2] followed by a float is 24 bytes (std140 needs 48).
+///
+/// C++ can't express "start on the next register if this vector would straddle one", so unlike std140 the compiler can't always place members for you.
+/// Instead every member is placed by the compiler with its natural alignment, and HLSL_CBUFFER_CHECK_FOLLOWS verifies
+/// at compile time that the compiler put it exactly where HLSL will. If a check fails, reorder the members (or add explicit padding).
+///
+/// Arrays and matrices are 16 aligned through their alias, and nested struct members need to be declared as Struct<T> so they are too.
+/// The packed size of a struct (without tail padding) can't be deduced, so declare it with HLSL_CBUFFER_STRUCT_END at global scope.
+///
+/// Here's an example use case:
+
+/**
+struct Light : public hlsl_cbuffer::UBOStruct<>
+{
+    hlsl_cbuffer::vec3 direction;       // offset 0
+    hlsl_cbuffer::float32_t intensity;  // offset 12
+    hlsl_cbuffer::vec3 color;           // offset 16
+};
+
+HLSL_CBUFFER_STRUCT_END(Light, color);
+HLSL_CBUFFER_CHECK_FOLLOWS(Light, direction, intensity);
+HLSL_CBUFFER_CHECK_FOLLOWS(Light, intensity, color);
+
+struct LightCBuffer
+{
+    hlsl_cbuffer::Array<Light, 4> lights;   // offset 0, stride 32
+    hlsl_cbuffer::int32_t nLights;          // offset 124, packed into the tail of lights[3]
+};
+
+HLSL_CBUFFER_CHECK_FOLLOWS(LightCBuffer, lights, nLights);
+**/
+
+// the register alignment is attached to alias templates, which only the GNU attribute syntax allows
+// elsewhere arrays and structs fall back to their natural alignment, and HLSL_CBUFFER_CHECK_FOLLOWS reports where padding is needed
+#if defined(__GNUC__) || defined(__clang__)
+    #define HLSL_CBUFFER_REGISTER_ALIGN ALIGN(16)
+#else
+    #define HLSL_CBUFFER_REGISTER_ALIGN
+#endif
+
+namespace hlsl_cbuffer
+{
+    // https://docs.microsoft.com/en-us/windows/win32/direct3dhlsl/dx-graphics-hlsl-packing-rules
+
+    static constexpr std::size_t RegisterSize = 16u;
+
+    using std140::float32_t;
+    using std140::double64_t;
+    using std140::Bool32;
+    using std140::bool32_t;
+    using std140::int32_t;
+    using std140::uint32_t;
+
+    using std140::Vector;
+
+    template <typename P, int SZ>
+    struct VectorAlignment
+    {
+        const static std::size_t AlignmentValue = alignof(P);
+    };
+
+    // no ALIGN, vectors are aligned to their component. The register boundary rule is verified by HLSL_CBUFFER_CHECK_FOLLOWS
+    typedef Vector<GLfloat, 2> vec2;
+    typedef Vector<GLfloat, 3> vec3;
+    typedef Vector<GLfloat, 4> vec4;
+
+    typedef Vector<Bool32, 2> bvec2;
+    typedef Vector<Bool32, 3> bvec3;
+    typedef Vector<Bool32, 4> bvec4;
+
+    typedef Vector<GLdouble, 2> dvec2;
+    typedef Vector<GLdouble, 3> dvec3;
+    typedef Vector<GLdouble, 4> dvec4;
+
+    typedef Vector<GLint, 2> ivec2;
+    typedef Vector<GLint, 3> ivec3;
+    typedef Vector<GLint, 4> ivec4;
+
+    typedef Vector<GLuint, 2> uvec2;
+    typedef Vector<GLuint, 3> uvec3;
+    typedef Vector<GLuint, 4> uvec4;
+
+    template <typename T, int SZ>
+    struct ArrayStorage;
+
+    /// Size of T once packed into a cbuffer, ie. without any tail padding
+    /// Structs have to declare theirs with HLSL_CBUFFER_STRUCT_END
+    template <typename T, typename Enable = void>
+    struct PackedSize
+    {
+        static_assert(sizeof(T) == 0, "declare the packed size of this struct with HLSL_CBUFFER_STRUCT_END(Type, lastMember)");
+    };
+
+    template <typename T>
+    struct PackedSize<T, typename std::enable_if<std::is_arithmetic<T>::value>::type>
+    {
+        static constexpr std::size_t value = sizeof(T);
+    };
+
+    template <>
+    struct PackedSize<Bool32>
+    {
+        static constexpr std::size_t value = sizeof(Bool32);
+    };
+
+    template <typename P, int SZ>
+    struct PackedSize<Vector<P, SZ> >
+    {
+        static constexpr std::size_t value = sizeof(P) * SZ;
+    };
+
+    template <typename T, int SZ>
+    struct PackedSize<ArrayStorage<T, SZ> >
+    {
+        static constexpr std::size_t value = sizeof(ArrayStorage<T, SZ>);
+    };
+
+    /// arrays are stored as raw bytes, since std::array can't leave the last element unpadded
+    template <typename T, int SZ>
+    struct ArrayStorage
+    {
+        static_assert(SZ > 0, "cbuffer arrays need at least one element");
+
+        static constexpr std::size_t Stride = (PackedSize<T>::value + RegisterSize - 1) / RegisterSize * RegisterSize;
+
+        T& operator[](std::size_t i) { return *reinterpret_cast<T*>(bytes + i * Stride); }
+        const T& operator[](std::size_t i) const { return *reinterpret_cast<const T*>(bytes + i * Stride); }
+
+        constexpr static std::size_t size() { return SZ; }
+
+        // aligned for the elements themselves, eg. doubles, even where HLSL_CBUFFER_REGISTER_ALIGN expands to nothing
+        alignas(alignof(T) > 4 ? alignof(T) : 4) unsigned char bytes[Stride * (SZ - 1) + PackedSize<T>::value] = {};
+    };
+
+    /// The alias carries the register alignment without rounding up the size, same trick as the std140 vec3 typedef
+    template <typename P, int SZ>
+    using Array HLSL_CBUFFER_REGISTER_ALIGN = ArrayStorage<P, SZ>;
+
+    // each column (or row) is a vector that starts its own register
+    template <typename P, int COLS, int ROWS, bool columnMajor = true>
+    using Matrix HLSL_CBUFFER_REGISTER_ALIGN = ArrayStorage< Vector<P, columnMajor ? ROWS : COLS>, columnMajor ? COLS : ROWS >;
+
+    /// Use for struct members of struct type, so they start on a register boundary without padding out their tail
+    template <typename T>
+    using Struct HLSL_CBUFFER_REGISTER_ALIGN = T;
+
+    typedef Matrix<float, 2, 2> mat2;
+    typedef Matrix<float, 3, 3> mat3;
+    typedef Matrix<float, 4, 4> mat4;
+
+    typedef Matrix<float, 2, 3> mat2x3;
+    typedef Matrix<float, 2, 4> mat2x4;
+
+    typedef Matrix<float, 3, 2> mat3x2;
+    typedef Matrix<float, 3, 4> mat3x4;
+
+    typedef Matrix<float, 4, 2> mat4x2;
+    typedef Matrix<float, 4, 3> mat4x3;
+
+    typedef Matrix<double, 2, 2> dmat2;
+    typedef Matrix<double, 3, 3> dmat3;
+    typedef Matrix<double, 4, 4> dmat4;
+
+    typedef Matrix<double, 2, 3> dmat2x3;
+    typedef Matrix<double, 2, 4> dmat2x4;
+
+    typedef Matrix<double, 3, 2> dmat3x2;
+    typedef Matrix<double, 3, 4> dmat3x4;
+
+    typedef Matrix<double, 4, 2> dmat4x2;
+    typedef Matrix<double, 4, 3> dmat4x3;
+
+    /// cbuffer structs are not rounded up to anything, the compiler aligns them to their largest member
+    template <typename T = float32_t>
+    struct UBOStruct
+    {
+    };
+
+    template <typename T>
+    struct IsRegisterAligned : std::integral_constant<bool, std::is_class<T>::value> {};
+
+    template <>
+    struct IsRegisterAligned<Bool32> : std::false_type {};
+
+    template <typename P, int SZ>
+    struct IsRegisterAligned<Vector<P, SZ> > : std::false_type {};
+
+    template <typename T>
+    struct ComponentAlignment
+    {
+        static constexpr std::size_t value = alignof(T);
+    };
+
+    template <typename P, int SZ>
+    struct ComponentAlignment<Vector<P, SZ> >
+    {
+        static constexpr std::size_t value = alignof(P);
+    };
+
+    /// Offset HLSL places a member of type T at, when the previous member ends at offset
+    template <typename T>
+    constexpr std::size_t placement(std::size_t offset)
+    {
+        if (IsRegisterAligned<T>::value)
+        {
+            return (offset + RegisterSize - 1) / RegisterSize * RegisterSize;
+        }
+
+        const std::size_t align = ComponentAlignment<T>::value;
+        const std::size_t placed = (offset + align - 1) / align * align;
+
+        // a scalar or vector can't straddle a register boundary
+        if ((placed % RegisterSize) + PackedSize<T>::value > RegisterSize)
+        {
+            return (placed + RegisterSize - 1) / RegisterSize * RegisterSize;
+        }
+
+        return placed;
+    }
+}
+
+/// Declares the packed size of a cbuffer struct, as the end of its last member
+#define HLSL_CBUFFER_STRUCT_END(TYPE, LAST_MEMBER) \
+    template <> struct hlsl_cbuffer::PackedSize<TYPE> \
+    { \
+        static constexpr std::size_t value = offsetof(TYPE, LAST_MEMBER) + hlsl_cbuffer::PackedSize<decltype(TYPE::LAST_MEMBER)>::value; \
+    }
+
+/// Verifies at compile time that NEXT_MEMBER is where HLSL will place it, given that it follows PREV_MEMBER
+#define HLSL_CBUFFER_CHECK_FOLLOWS(TYPE, PREV_MEMBER, NEXT_MEMBER) \
+    static_assert(hlsl_cbuffer::placement<decltype(TYPE::NEXT_MEMBER)>(offsetof(TYPE, PREV_MEMBER) + hlsl_cbuffer::PackedSize<decltype(TYPE::PREV_MEMBER)>::value) \
+        == offsetof(TYPE, NEXT_MEMBER), #TYPE "::" #NEXT_MEMBER " is not where the HLSL cbuffer packing rules put it, reorder or pad the members")
@@ -0,0 +1,284 @@
+#pragma once
+#include "DynamicLayout.h"
+#include "GlslBlockParser.h"
+#include <algorithm>
+#include <cstring>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+/// Intro and Usage
+/// Moving the CPU side copies of a block to a new layout, eg. when a shader is hot reloaded with members added, removed or reordered.
+/// Rather than throwing the data away, the old and new layouts are diffed once into a MigrationPlan, which is then applied to every block.
+///
+/// Both layouts are flattened to their leaves : every scalar, vector, matrix column (or row, for row_major), struct member and array element,
+/// named by its path, eg. "lights[3].color" or "model[2]" for the third column of model. A leaf of the new layout takes the bytes of the old
+/// leaf with the same path and type, so a member that moved is copied to its new offset, and an array that grew keeps its old elements.
+/// Leaves with no match, new members or ones whose type changed, come from a block of defaults, or are zeroed.
+///
+/// The plan is a list of memcpy runs, coalesced over members that keep their relative offsets and the padding between them,
+/// so an unchanged stretch of a block is one copy however many members it holds. Applying it makes no lookups.
+///
+/// Leaves come from a DynamicLayout, or from a block of a shader parsed by GlslBlockParser.h. The unsized array at the end of a buffer block isn't migrated.
+///
+/// Here's an example use case:
+
+/**
+// before the reload
+std140::DynamicLayout oldLayout = loadMaterialSchema(...);
+std::vector<unsigned char> oldBlocks(materialCount * oldLayout.size());
+
+// after it
+std140::DynamicLayout newLayout = loadMaterialSchema(...);
+std::vector<unsigned char> newBlocks(materialCount * newLayout.size());
+
+const std140::MigrationPlan plan = std140::planMigration(std140::migrationLeaves(oldLayout), std140::migrationLeaves(newLayout));
+plan.apply(oldBlocks.data(), oldLayout.size(), newBlocks.data(), newLayout.size(), materialCount, defaultMaterial.data());
+**/
+
+namespace std140
+{
+    /// A scalar, vector or matrix column that a migration copies whole
+    struct MigrationLeaf
+    {
+        std::string path;
+        std::string type;       // the GLSL type name, and for matrix columns the matrix and its majorness, eg. "mat3 column"
+        std::size_t offset;
+        std::size_t size;       // bytes holding values, a vec3 is 12
+    };
+
+    struct MigrationCopy
+    {
+        std::size_t from;
+        std::size_t to;
+        std::size_t size;
+    };
+
+    /// Bytes of padding a copy run may span to join the next member, rather than starting another run
+    constexpr std::size_t MigrationMaxGap = 16;
+
+    struct MigrationPlan
+    {
+        std::size_t fromSize = 0;
+        std::size_t toSize = 0;
+
+        std::vector<MigrationCopy> copies;      // from the old block
+        std::vector<MigrationCopy> defaults;    // from the defaults block, at the same offset
+
+        std::size_t keptLeaves = 0;
+        std::size_t addedLeaves = 0;
+        std::size_t droppedLeaves = 0;
+
+        /// Moves one block. defaults is laid out like the new block, or null to zero the new members
+        void apply(const void* from, void* to, const void* defaults = nullptr) const
+        {
+            apply(from, fromSize, to, toSize, 1, defaults);
+        }
+
+        /// Moves count blocks, fromStride and toStride bytes apart, in one pass
+        void apply(const void* from, std::size_t fromStride, void* to, std::size_t toStride, std::size_t count, const void* defaults = nullptr) const
+        {
+            const unsigned char* src = static_cast<const unsigned char*>(from);
+            const unsigned char* def = static_cast<const unsigned char*>(defaults);
+            unsigned char* dst = static_cast<unsigned char*>(to);
+
+            for (std::size_t b = 0; b < count; b++, src += fromStride, dst += toStride)
+            {
+                for (const MigrationCopy& copy : copies)
+                {
+                    std::memcpy(dst + copy.to, src + copy.from, copy.size);
+                }
+
+                for (const MigrationCopy& copy : this->defaults)
+                {
+                    if (def)
+                    {
+                        std::memcpy(dst + copy.to, def + copy.from, copy.size);
+                    }
+                    else
+                    {
+                        std::memset(dst + copy.to, 0, copy.size);
+                    }
+                }
+            }
+        }
+    };
+
+    namespace detail
+    {
+        inline void appendMigrationValue(std::vector<MigrationLeaf>& leaves, const std::string& path, DynamicType type, std::size_t offset, std::size_t matrixStride, bool rowMajor)
+        {
+            const std::size_t componentSize = dynamicComponentSize(type.component);
+
+            if (type.columns > 1)
+            {
+                const int vectors = rowMajor ? type.rows : type.columns;
+                const int length = rowMajor ? type.columns : type.rows;
+                const std::string vectorType = dynamicTypeName(type) + (rowMajor ? " row" : " column");
+
+                for (int i = 0; i < vectors; i++)
+                {
+                    leaves.push_back(MigrationLeaf{ path + "[" + std::to_string(i) + "]", vectorType, offset + i * matrixStride, componentSize * length });
+                }
+            }
+            else
+            {
+                leaves.push_back(MigrationLeaf{ path, dynamicTypeName(type), offset, componentSize * type.rows });
+            }
+        }
+
+        template <typename Shader>
+        void appendMigrationFields(std::vector<MigrationLeaf>& leaves, const Shader& shader, std::size_t first, std::size_t count, int L, std::size_t base, const std::string& prefix)
+        {
+            for (std::size_t f = first; f < first + count; f++)
+            {
+                const GlslField& field = shader.fields[f];
+
+                if (field.runtimeSized)
+                {
+                    continue;
+                }
+
+                const std::size_t elements = field.arrayLength ? field.arrayLength : 1;
+                const std::size_t stride = field.arrayLength ? shader.arrayStride(field, L) : 0;
+
+                for (std::size_t e = 0; e < elements; e++)
+                {
+                    const std::string path = prefix + std::string(field.name) + (field.arrayLength ? "[" + std::to_string(e) + "]" : "");
+                    const std::size_t offset = base + field.offset[L] + e * stride;
+
+                    if (field.type.kind == GlslTypeKind::Struct)
+                    {
+                        const GlslStruct& decl = shader.structs[field.type.structIndex];
+                        appendMigrationFields(leaves, shader, decl.firstField, decl.fieldCount, L, offset, path + ".");
+                    }
+                    else
+                    {
+                        appendMigrationValue(leaves, path, dynamicType(field.typeName), offset, shader.matrixStride(field.type, field.rowMajor, L), field.rowMajor);
+                    }
+                }
+            }
+        }
+    }
+
+    /// The leaves of a block laid out by a DynamicLayout
+    inline std::vector<MigrationLeaf> migrationLeaves(const DynamicLayout& layout)
+    {
+        std::vector<MigrationLeaf> leaves;
+
+        for (const DynamicMember& member : layout.members())
+        {
+            const std::size_t elements = member.arrayLength ? member.arrayLength : 1;
+
+            for (std::size_t e = 0; e < elements; e++)
+            {
+                const std::string path = member.name + (member.arrayLength ? "[" + std::to_string(e) + "]" : "");
+                detail::appendMigrationValue(leaves, path, member.type, member.offset + e * member.arrayStride, member.matrixStride, false);
+            }
+        }
+
+        return leaves;
+    }
+
+    /// The leaves of a std140 or std430 block of a parsed shader, by block or instance name. Empty if there's no such block
+    template <typename Shader>
+    std::vector<MigrationLeaf> migrationLeaves(const Shader& shader, std::string_view blockName)
+    {
+        std::vector<MigrationLeaf> leaves;
+
+        const std::size_t b = shader.blockIndex(blockName);
+        if (b == Shader::npos || shader.blocks[b].layout == GlslLayout::Other)
+        {
+            return leaves;
+        }
+
+        const int L = shader.blocks[b].layout == GlslLayout::Std140 ? 0 : 1;
+        detail::appendMigrationFields(leaves, shader, shader.blocks[b].firstField, shader.blocks[b].fieldCount, L, 0, std::string());
+
+        return leaves;
+    }
+
+    /// Diffs two layouts by leaf path and type into the copies that move a block from one to the other
+    inline MigrationPlan planMigration(const std::vector<MigrationLeaf>& from, const std::vector<MigrationLeaf>& to)
+    {
+        MigrationPlan plan;
+
+        for (const MigrationLeaf& leaf : from)
+        {
+            plan.fromSize = std::max(plan.fromSize, leaf.offset + leaf.size);
+        }
+
+        for (const MigrationLeaf& leaf : to)
+        {
+            plan.toSize = std::max(plan.toSize, leaf.offset + leaf.size);
+        }
+
+        std::unordered_map<std::string, const MigrationLeaf*> byPath;
+        for (const MigrationLeaf& leaf : from)
+        {
+            byPath.emplace(leaf.path, &leaf);
+        }
+
+        std::vector<const MigrationLeaf*> ordered;
+        for (const MigrationLeaf& leaf : to)
+        {
+            ordered.push_back(&leaf);
+        }
+        std::sort(ordered.begin(), ordered.end(), [](const MigrationLeaf* a, const MigrationLeaf* b) { return a->offset < b->offset; });
+
+        // walking the new layout in offset order, a copy run grows while the old offsets keep pace with the new ones,
+        // and a defaults run while no copied leaf comes between. Each kind of leaf ends the other's run, so no run spans a leaf
+        // of the other kind, runs never overlap, and their order doesn't matter
+        const std::size_t none = std::size_t(-1);
+        std::size_t copy = none;
+        std::size_t fill = none;
+
+        for (const MigrationLeaf* leaf : ordered)
+        {
+            const auto match = byPath.find(leaf->path);
+
+            if (match != byPath.end() && match->second->type == leaf->type && match->second->size == leaf->size)
+            {
+                const std::size_t from = match->second->offset;
+                MigrationCopy* run = copy != none ? &plan.copies[copy] : nullptr;
+                const std::size_t runEnd = run ? run->to + run->size : 0;
+
+                if (run && leaf->offset >= runEnd && leaf->offset - runEnd <= MigrationMaxGap && from >= run->from && from - run->from == leaf->offset - run->to)
+                {
+                    run->size = leaf->offset + leaf->size - run->to;
+                }
+                else
+                {
+                    copy = plan.copies.size();
+                    plan.copies.push_back(MigrationCopy{ from, leaf->offset, leaf->size });
+                }
+
+                fill = none;
+                plan.keptLeaves++;
+            }
+            else
+            {
+                copy = none;
+
+                MigrationCopy* run = fill != none ? &plan.defaults[fill] : nullptr;
+                const std::size_t runEnd = run ? run->to + run->size : 0;
+
+                if (run && leaf->offset >= runEnd && leaf->offset - runEnd <= MigrationMaxGap)
+                {
+                    run->size = leaf->offset + leaf->size - run->to;
+                }
+                else
+                {
+                    fill = plan.defaults.size();
+                    plan.defaults.push_back(MigrationCopy{ leaf->offset, leaf->offset, leaf->size });
+                }
+
+                plan.addedLeaves++;
+            }
+        }
+
+        plan.droppedLeaves = from.size() - plan.keptLeaves;
+
+        return plan;
+    }
+}
@@ -0,0 +1,275 @@
+#pragma once
+#include "GlslBlockParser.h"
+
+/// Intro and Usage
+/// Finds the member order of a struct or block that wastes the least space to padding under the std140 (or std430) rules.
+/// A vec3 leaves a 4 byte hole that only a 4 byte scalar can fill, and a scalar in front of a vec4 pushes it out by 12 bytes,
+/// so hand packing (as in InstanceMaterial, where the floats sit in the vec3 tails) is easy to get wrong and easy to undo by accident.
+///
+/// planLayout() works on a declaration parsed by GlslBlockParser.h and searches the member orders with branch and bound,
+/// trying members with the same alignment and size only once per position. For a struct the size it minimizes is also its array stride.
+/// A block's size is rounded up to its largest member alignment (at least 16 in std140), as sizeof the C++ struct and the GL block data size are.
+/// When several orders tie, the first found is kept, and the declared order is tried first, so an already optimal struct is left alone.
+/// The unsized array at the end of a buffer block stays last.
+///
+/// It's constexpr, so a struct can be checked for packing in a static_assert. tools/std140plan.cpp runs it over a GLSL file
+/// and prints the reordered GLSL and C++ declarations.
+///
+/// Here's an example use case:
+
+/**
+constexpr std140::GlslShader shader = std140::parseGlsl(R"(
+    struct Material { float roughness; vec3 surfaceColor; float metallic; vec3 emissive; };
+)");
+
+constexpr std140::LayoutPlan plan = std140::planLayout(shader, "Material");
+
+static_assert(plan.originalSize == 48 && plan.size == 32, "");
+
+// surfaceColor, roughness, emissive, metallic
+for (std::size_t i = 0; i < plan.count; i++)
+{
+    std::cout << shader.fields[shader.structs[0].firstField + plan.order[i]].name << std::endl;
+}
+**/
+
+namespace std140
+{
+    /// UBO_MEMBERS lists up to 32 members, and so does the planner
+    static constexpr std::size_t MaxPlannedMembers = 32;
+
+    struct LayoutPlan
+    {
+        std::array<std::size_t, MaxPlannedMembers> order{};     // member indices, relative to the first member, in the planned order
+        std::size_t count = 0;
+        std::size_t originalSize = 0;                           // size in the declared order : the array stride of a struct, the rounded up size of a block, the offset of a trailing unsized array
+        std::size_t size = 0;                                   // size in the planned order
+        bool exhaustive = true;                                 // false if the search ran out of its budget, and the plan may not be the best one
+
+        constexpr std::size_t savedBytes() const { return originalSize - size; }
+
+        constexpr bool reordered() const
+        {
+            for (std::size_t i = 0; i < count; i++)
+            {
+                if (order[i] != i)
+                {
+                    return true;
+                }
+            }
+            return false;
+        }
+    };
+
+    namespace detail
+    {
+        struct PlannedMember
+        {
+            std::size_t alignment;
+            std::size_t size;
+        };
+
+        class LayoutSearch
+        {
+        public:
+
+            // bounds the constexpr evaluation, large structs with many distinct member types get the best order found so far
+            static constexpr std::size_t NodeBudget = 200000;
+
+            constexpr LayoutSearch(const std::array<PlannedMember, MaxPlannedMembers>& members, std::size_t count, std::size_t pinned, std::size_t endAlignment)
+                : members(members), count(count), pinned(pinned), endAlignment(endAlignment)
+            {
+            }
+
+            constexpr LayoutPlan run()
+            {
+                for (std::size_t i = 0; i < count; i++)
+                {
+                    plan.order[i] = i;
+                }
+
+                plan.count = count;
+                plan.originalSize = sizeOf(plan.order);
+                plan.size = plan.originalSize;
+
+                // largest alignment first is usually close, and gives the search a tight bound to start with
+                std::array<std::size_t, MaxPlannedMembers> sorted = plan.order;
+                for (std::size_t i = 1; i < count - pinned; i++)
+                {
+                    for (std::size_t j = i; j > 0 && members[sorted[j]].alignment > members[sorted[j - 1]].alignment; j--)
+                    {
+                        const std::size_t t = sorted[j];
+                        sorted[j] = sorted[j - 1];
+                        sorted[j - 1] = t;
+                    }
+                }
+
+                if (sizeOf(sorted) < plan.size)
+                {
+                    plan.size = sizeOf(sorted);
+                    plan.order = sorted;
+                }
+
+                std::size_t remaining = 0;
+                for (std::size_t i = 0; i < count - pinned; i++)
+                {
+                    remaining += members[i].size;
+                }
+
+                // the pinned member keeps its place at the end
+                current = plan.order;
+                search(0, 0, remaining);
+
+                return plan;
+            }
+
+        private:
+
+            static constexpr std::size_t roundUp(std::size_t value, std::size_t alignment)
+            {
+                return (value + alignment - 1) / alignment * alignment;
+            }
+
+            constexpr std::size_t place(std::size_t offset, std::size_t i) const
+            {
+                return roundUp(offset, members[i].alignment) + members[i].size;
+            }
+
+            /// Size with the free members in order, followed by the pinned one
+            constexpr std::size_t finish(std::size_t offset) const
+            {
+                if (pinned)
+                {
+                    offset = place(offset, count - 1);
+                }
+                return roundUp(offset, endAlignment);
+            }
+
+            constexpr std::size_t sizeOf(const std::array<std::size_t, MaxPlannedMembers>& order) const
+            {
+                std::size_t offset = 0;
+                for (std::size_t i = 0; i < count - pinned; i++)
+                {
+                    offset = place(offset, order[i]);
+                }
+                return finish(offset);
+            }
+
+            constexpr void search(std::size_t depth, std::size_t offset, std::size_t remaining)
+            {
+                if (depth == count - pinned)
+                {
+                    const std::size_t size = finish(offset);
+                    if (size < plan.size)
+                    {
+                        plan.size = size;
+                        plan.order = current;
+                    }
+                    return;
+                }
+
+                // padding only ever adds to the remaining sizes
+                if (finish(offset + remaining) >= plan.size)
+                {
+                    return;
+                }
+
+                if (++nodes > NodeBudget)
+                {
+                    plan.exhaustive = false;
+                    return;
+                }
+
+                for (std::size_t i = 0; i < count - pinned; i++)
+                {
+                    if (used[i] || !firstOfKind(i))
+                    {
+                        continue;
+                    }
+
+                    used[i] = true;
+                    current[depth] = i;
+                    search(depth + 1, place(offset, i), remaining - members[i].size);
+                    used[i] = false;
+                }
+            }
+
+            /// Members with the same alignment and size are interchangeable, only the first unused one is tried, which also keeps their declared order
+            constexpr bool firstOfKind(std::size_t i) const
+            {
+                for (std::size_t j = 0; j < i; j++)
+                {
+                    if (!used[j] && members[j].alignment == members[i].alignment && members[j].size == members[i].size)
+                    {
+                        return false;
+                    }
+                }
+                return true;
+            }
+
+            const std::array<PlannedMember, MaxPlannedMembers>& members;
+            std::size_t count;
+            std::size_t pinned;
+            std::size_t endAlignment;
+
+            LayoutPlan plan{};
+            std::array<std::size_t, MaxPlannedMembers> current{};
+            std::array<bool, MaxPlannedMembers> used{};
+            std::size_t nodes = 0;
+        };
+    }
+
+    /// The member order of the struct or block called name that minimizes its size under layout (std140 or std430).
+    /// Blocks are planned with their own layout. Returns an empty plan (count 0) if there is no such declaration,
+    /// the block has no std140 / std430 layout, or it has more than MaxPlannedMembers members
+    template <typename Shader>
+    constexpr LayoutPlan planLayout(const Shader& shader, std::string_view name, GlslLayout layout = GlslLayout::Std140)
+    {
+        std::size_t first = 0;
+        std::size_t count = 0;
+        std::size_t endAlignment = 1;
+        std::size_t pinned = 0;
+
+        const std::size_t b = shader.blockIndex(name);
+        const std::size_t s = shader.structIndex(name);
+
+        if (b != Shader::npos)
+        {
+            layout = shader.blocks[b].layout;
+            first = shader.blocks[b].firstField;
+            count = shader.blocks[b].fieldCount;
+            pinned = (count && shader.fields[first + count - 1].runtimeSized) ? 1 : 0;
+
+            // the C++ struct and the block data size are rounded up to the largest member, and to a vec4 in std140
+            for (std::size_t i = 0; !pinned && i < count; i++)
+            {
+                const std::size_t alignment = shader.fieldAlignment(shader.fields[first + i], layout == GlslLayout::Std140 ? 0 : 1);
+                endAlignment = alignment > endAlignment ? alignment : endAlignment;
+            }
+
+            endAlignment = (!pinned && layout == GlslLayout::Std140 && endAlignment < 16) ? 16 : endAlignment;
+        }
+        else if (s != Shader::npos)
+        {
+            first = shader.structs[s].firstField;
+            count = shader.structs[s].fieldCount;
+            endAlignment = shader.structs[s].alignment[layout == GlslLayout::Std140 ? 0 : 1];
+        }
+
+        if (layout == GlslLayout::Other || count == 0 || count > MaxPlannedMembers)
+        {
+            return LayoutPlan{};
+        }
+
+        const int L = layout == GlslLayout::Std140 ? 0 : 1;
+
+        std::array<detail::PlannedMember, MaxPlannedMembers> members{};
+        for (std::size_t i = 0; i < count; i++)
+        {
+            const GlslField& field = shader.fields[first + i];
+            members[i] = detail::PlannedMember{ shader.fieldAlignment(field, L), field.runtimeSized ? 0 : shader.fieldSize(field, L) };
+        }
+
+        return detail::LayoutSearch(members, count, pinned, endAlignment).run();
+    }
+}
@@ -0,0 +1,143 @@
+#pragma once
+#include "Std140.h"
+
+/// Intro and Usage
+/// This header defines types you can use to declare Metal Shading Language buffers (constant and device address space) in the client code
+/// It mirrors the vocabulary of Std140.h, so a struct written against std140:: can be moved to msl:: by changing the namespace
+///
+/// The MSL rules, from the size and alignment table of the MSL specification :
+///     scalars are aligned to their size
+///     float2 is 8 bytes aligned to 8, float3 and float4 are 16 bytes aligned to 16. Unlike GLSL a float3 really is 16 bytes, nothing packs into its tail
+///     packed_float2/3/4 are aligned to their component, so a packed_float3 is 12 bytes
+///     matrices are arrays of column vectors, so a float3x3 is 48 bytes and a float2x2 is 16
+///     arrays are aligned to their element, and the stride is the size of an element, so a float[N] is 4 bytes per element
+///     structs are aligned to their largest member
+///
+/// Apart from float3 those are the rules the C++ compiler already follows, so only vec3 needs special treatment.
+/// MSL has no double types, and bool is 1 byte.
+///
+/// Here's an example use case:
+
+/**
+struct Light : public msl::UBOStruct<>
+{
+    msl::vec3 direction;              // offset 0, 16 bytes
+    msl::packed_vec3 color;           // offset 16, 12 bytes
+    msl::float32_t intensity;         // offset 28
+};
+
+struct LightBuffer
+{
+    msl::Array<msl::float32_t, 4> weights;  // stride 4
+    msl::Array<Light, 8> lights;            // stride 32
+};
+**/
+
+namespace msl
+{
+    // https://developer.apple.com/metal/Metal-Shading-Language-Specification.pdf table 2.2 and 2.3
+
+    using std140::float32_t;
+    using std140::int32_t;
+    using std140::uint32_t;
+
+    using std140::Vector;
+
+    // MSL vectors are aligned to their size, with 3 component ones aligned like 4, the same rule std140 uses
+    using std140::VectorAlignment;
+
+    /// 3 component vectors are padded out to the size of 4 components, so they are a real struct rather than an aligned typedef
+    template <typename P>
+    struct ALIGN((VectorAlignment<P, 3>::AlignmentValue)) Vector3 : public Vector<P, 3>
+    {
+    };
+
+    typedef ALIGN((VectorAlignment<GLfloat, 2>::AlignmentValue)) Vector<GLfloat, 2> vec2;
+    typedef Vector3<GLfloat> vec3;
+    typedef ALIGN((VectorAlignment<GLfloat, 4>::AlignmentValue)) Vector<GLfloat, 4> vec4;
+
+    typedef ALIGN((VectorAlignment<GLint, 2>::AlignmentValue)) Vector<GLint, 2> ivec2;
+    typedef Vector3<GLint> ivec3;
+    typedef ALIGN((VectorAlignment<GLint, 4>::AlignmentValue)) Vector<GLint, 4> ivec4;
+
+    typedef ALIGN((VectorAlignment<GLuint, 2>::AlignmentValue)) Vector<GLuint, 2> uvec2;
+    typedef Vector3<GLuint> uvec3;
+    typedef ALIGN((VectorAlignment<GLuint, 4>::AlignmentValue)) Vector<GLuint, 4> uvec4;
+
+    /// Opt in packed vectors, packed_float3 etc. on the Metal side. Aligned to their component, with no padding.
+    typedef Vector<GLfloat, 2> packed_vec2;
+    typedef Vector<GLfloat, 3> packed_vec3;
+    typedef Vector<GLfloat, 4> packed_vec4;
+
+    typedef Vector<GLint, 2> packed_ivec2;
+    typedef Vector<GLint, 3> packed_ivec3;
+    typedef Vector<GLint, 4> packed_ivec4;
+
+    typedef Vector<GLuint, 2> packed_uvec2;
+    typedef Vector<GLuint, 3> packed_uvec3;
+    typedef Vector<GLuint, 4> packed_uvec4;
+
+    // scalars, 3 component vectors and structs already have their MSL size and alignment, so array elements of those types are stored as is
+    template <typename T>
+    struct ArrayAlignment
+    {
+        static constexpr std::size_t AlignmentValue = alignof(T);
+        typedef T ArrayAlignedType;
+    };
+
+    // 2 and 4 component vectors get their alignment from the typedef, which is lost as a template argument, so recover it here
+    // a bare Vector<P, 3> can only be a packed_vec3 (vec3 is a Vector3), so it keeps a 12 byte stride.
+    // Array<packed_vec2, N> and Array<packed_vec4, N> can't be told apart from the aligned ones and are laid out like them
+    template <typename P, int SZ>
+    struct ArrayAlignment<Vector<P, SZ> >
+    {
+        static constexpr std::size_t AlignmentValue = SZ == 3 ? alignof(P) : VectorAlignment<P, SZ>::AlignmentValue;
+        typedef std140::ArrayAlignedStruct<Vector<P, SZ>, AlignmentValue> ArrayAlignedType;
+    };
+
+    template <typename P, int SZ>
+    struct Array : public std::array<typename ArrayAlignment<P>::ArrayAlignedType, SZ> {};
+
+    template <typename P, int SZ>
+    struct MatrixColumn
+    {
+        typedef Vector<P, SZ> type;
+    };
+
+    template <typename P>
+    struct MatrixColumn<P, 3>
+    {
+        typedef Vector3<P> type;
+    };
+
+    template <typename P, int COLS, int ROWS, bool columnMajor = true>
+    struct Matrix : public Array< typename MatrixColumn<P, columnMajor ? ROWS : COLS>::type, columnMajor ? COLS : ROWS >
+    {
+    };
+
+    typedef Matrix<float, 2, 2> mat2;
+    typedef Matrix<float, 3, 3> mat3;
+    typedef Matrix<float, 4, 4> mat4;
+
+    typedef Matrix<float, 2, 3> mat2x3;
+    typedef Matrix<float, 2, 4> mat2x4;
+
+    typedef Matrix<float, 3, 2> mat3x2;
+    typedef Matrix<float, 3, 4> mat3x4;
+
+    typedef Matrix<float, 4, 2> mat4x2;
+    typedef Matrix<float, 4, 3> mat4x3;
+
+    /// MSL structs are aligned to their largest member, which the compiler does on its own.
+    /// The template argument is kept so the declarations read the same as std140.
+    template <typename T = float32_t>
+    struct ALIGN(alignof(T)) UBOStruct
+    {
+    };
+
+    using std140::NoHeader;
+
+    /// Header plus unsized trailing array (a device pointer indexed past a header on the Metal side). See std140::BasicRuntimeArray
+    template <typename HEADER, typename P, std::size_t HEADER_END = (std::is_empty<HEADER>::value ? 0 : sizeof(HEADER))>
+    using RuntimeArray = std140::BasicRuntimeArray<HEADER, typename ArrayAlignment<P>::ArrayAlignedType, HEADER_END>;
+}
@@ -0,0 +1,217 @@
+#pragma once
+#include "UBOReflection.h"
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include <string>
+#include <vector>
+
+/// Intro and Usage
+/// How much of a block is padding. std140 is generous with it : an Array<float32_t, N> spends 12 of every 16 bytes on it,
+/// a mat3 4 of every 16, and a struct rounds up to 16. All of it is uploaded every time the block is.
+///
+/// usefulBytes<T>() is the number of bytes of T that hold values, worked out from the UBO_MEMBERS lists at compile time.
+/// paddingTable<T>() splits sizeof(T) over the members of T : each member owns the bytes up to the next one, so padding
+/// in front of a member is counted against the one before it, and the tail of the block against the last member.
+/// Arrays also report the useful bytes of one element against their stride.
+///
+/// For a codebase wide view, STD140_PADDING_REPORT(T, uploadsPerFrame) registers a block, and printPaddingReport() lists
+/// the members wasting the most bytes per frame across everything registered. tools/std140report.cpp is a main() for it,
+/// linked with the files doing the registering.
+///
+/// Here's an example use case:
+
+/**
+struct Particles
+{
+    std140::Array<std140::float32_t, 64> sizes;
+    std140::Array<std140::vec4, 64> colors;
+
+    UBO_MEMBERS(Particles, sizes, colors)
+};
+
+static_assert(std140::usefulBytes<Particles>() == 64 * 4 + 64 * 16, "");
+static_assert(std140::paddingTable<Particles>().members[0].paddingBytes() == 64 * 12, "sizes is three quarters padding");
+
+// in any .cpp of the report target
+STD140_PADDING_REPORT(Particles, 4)     // uploaded 4 times a frame
+**/
+
+namespace std140
+{
+    /// Bytes of T that hold values rather than padding
+    template <typename T>
+    constexpr std::size_t usefulBytes()
+    {
+        typedef typename UnwrapArrayElement<T>::type U;
+
+        if constexpr (IsLeaf<U>::value)
+        {
+            return ValueSize<U>::value;
+        }
+        else if constexpr (IsArray<U>::value)
+        {
+            return ArrayTraits<U>::Length * usefulBytes<typename ArrayTraits<U>::AlignedType>();
+        }
+        else
+        {
+            static_assert(HasMembers<U>::value, "list the members of nested structs with UBO_MEMBERS");
+
+            std::size_t useful = 0;
+            forEachMember<U>([&useful](auto member)
+            {
+                useful += usefulBytes<typename decltype(member)::type>();
+            });
+            return useful;
+        }
+    }
+
+    struct MemberPadding
+    {
+        const char* name;
+        std::size_t offset;
+        std::size_t bytes;              // from the member to the next one, or to the end of the block
+        std::size_t usefulBytes;
+        std::size_t arrayLength;        // 0 if the member isn't an array
+        std::size_t arrayStride;
+        std::size_t elementUsefulBytes; // useful bytes of one array element
+
+        constexpr std::size_t paddingBytes() const { return bytes - usefulBytes; }
+    };
+
+    template <std::size_t N>
+    struct PaddingTable
+    {
+        std::size_t bytes;
+        std::size_t usefulBytes;
+        std::array<MemberPadding, N> members;
+
+        constexpr std::size_t paddingBytes() const { return bytes - usefulBytes; }
+    };
+
+    /// Useful and padding bytes of T, in total and per UBO_MEMBERS member, in declaration order
+    template <typename T>
+    constexpr PaddingTable<memberCount<T>()> paddingTable()
+    {
+        constexpr auto table = reflect<T>();
+
+        PaddingTable<memberCount<T>()> padding{ sizeof(T), usefulBytes<T>(), {} };
+        std::size_t i = 0;
+
+        forEachMember<T>([&](auto member)
+        {
+            typedef typename UnwrapArrayElement<typename decltype(member)::type>::type M;
+
+            MemberPadding& entry = padding.members[i];
+
+            entry.name = table[i].name;
+            entry.offset = table[i].offset;
+            entry.bytes = (i + 1 < table.size() ? table[i + 1].offset : sizeof(T)) - table[i].offset;
+            entry.usefulBytes = usefulBytes<M>();
+            entry.arrayLength = table[i].arrayLength;
+            entry.arrayStride = table[i].arrayStride;
+
+            if constexpr (IsArray<M>::value && !MatrixTraits<M>::IsMatrix)
+            {
+                entry.elementUsefulBytes = usefulBytes<typename ArrayTraits<M>::AlignedType>();
+            }
+
+            i++;
+        });
+
+        return padding;
+    }
+
+    /// A registered block, see STD140_PADDING_REPORT
+    struct BlockPadding
+    {
+        std::string name;
+        std::size_t bytes;
+        std::size_t usefulBytes;
+        double uploadsPerFrame;
+        std::vector<MemberPadding> members;
+    };
+
+    inline std::vector<BlockPadding>& paddingRegistry()
+    {
+        static std::vector<BlockPadding> registry;
+        return registry;
+    }
+
+    template <typename T>
+    bool registerPadding(const char* name, double uploadsPerFrame = 1.0)
+    {
+        constexpr auto table = paddingTable<T>();
+
+        paddingRegistry().push_back(BlockPadding{ name, table.bytes, table.usefulBytes, uploadsPerFrame,
+            std::vector<MemberPadding>(table.members.begin(), table.members.end()) });
+
+        return true;
+    }
+
+    /// Lists the worst members across the registered blocks, by padding bytes uploaded per frame, then every block's totals
+    inline void printPaddingReport(std::ostream& out, std::size_t worst = 20)
+    {
+        struct Offender
+        {
+            const BlockPadding* block;
+            const MemberPadding* member;
+            double perFrame;
+        };
+
+        std::vector<Offender> offenders;
+        std::vector<const BlockPadding*> blocks;
+
+        for (const BlockPadding& block : paddingRegistry())
+        {
+            blocks.push_back(&block);
+
+            for (const MemberPadding& member : block.members)
+            {
+                if (member.paddingBytes())
+                {
+                    offenders.push_back(Offender{ &block, &member, member.paddingBytes() * block.uploadsPerFrame });
+                }
+            }
+        }
+
+        std::stable_sort(offenders.begin(), offenders.end(), [](const Offender& a, const Offender& b) { return a.perFrame > b.perFrame; });
+        std::stable_sort(blocks.begin(), blocks.end(), [](const BlockPadding* a, const BlockPadding* b)
+        {
+            return (a->bytes - a->usefulBytes) * a->uploadsPerFrame > (b->bytes - b->usefulBytes) * b->uploadsPerFrame;
+        });
+
+        out << "worst members, by padding bytes uploaded per frame\n\n";
+        out << std::setw(14) << "padding/frame" << std::setw(10) << "padding" << std::setw(10) << "bytes" << "  member\n";
+
+        for (std::size_t i = 0; i < offenders.size() && i < worst; i++)
+        {
+            const Offender& o = offenders[i];
+
+            out << std::setw(14) << o.perFrame << std::setw(10) << o.member->paddingBytes() << std::setw(10) << o.member->bytes
+                << "  " << o.block->name << "::" << o.member->name;
+
+            if (o.member->arrayLength)
+            {
+                out << "[" << o.member->arrayLength << "], " << o.member->elementUsefulBytes << " of " << o.member->arrayStride << " bytes per element";
+            }
+
+            out << "\n";
+        }
+
+        out << "\nblocks\n\n";
+        out << std::setw(14) << "padding/frame" << std::setw(10) << "padding" << std::setw(10) << "bytes" << std::setw(8) << "useful" << "  block\n";
+
+        for (const BlockPadding* block : blocks)
+        {
+            const std::size_t padding = block->bytes - block->usefulBytes;
+
+            out << std::setw(14) << padding * block->uploadsPerFrame << std::setw(10) << padding << std::setw(10) << block->bytes
+                << std::setw(7) << (block->bytes ? 100 * block->usefulBytes / block->bytes : 100) << "%  " << block->name << "\n";
+        }
+    }
+}
+
+/// Registers T for printPaddingReport() at static initialization, from any .cpp linked into the report
+#define STD140_PADDING_REPORT(TYPE, UPLOADS_PER_FRAME) \
+    static const bool UBO_PP_CAT(std140PaddingReport_, __LINE__) = std140::registerPadding<TYPE>(#TYPE, UPLOADS_PER_FRAME);
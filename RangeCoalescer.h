@@ -0,0 +1,220 @@
+#pragma once
+#include "UBOReflection.h"
+#include "Transcode.h"
+#include <algorithm>
+#include <vector>
+
+/// Intro and Usage
+/// Turns the dirty ranges of a block into the list of uploads to make. Each range uploaded on its own costs an API call,
+/// and one upload spanning all of them sends every clean byte in between, so which ranges to join depends on the cost of each.
+///
+/// UploadCost models an upload as a fixed cost per call plus a cost per byte. Joining two neighbouring ranges saves a call and
+/// sends the gap between them, so it pays exactly when the gap is below perCall / perByte bytes : that break even gap is the
+/// whole decision, and joining every gap under it gives the cheapest list under the model.
+///
+/// With the leaves of a block (memberLeaves<T>(), every scalar, vector and matrix column reachable through UBO_MEMBERS) the ranges are
+/// also snapped to member boundaries first : a range covering part of a member grows to all of it, and ends falling in padding
+/// are trimmed back to the members, so an upload never starts or stops inside a value.
+///
+/// test/bench.cpp prints the calls and bytes the PBR demo blocks take at a range of gaps, built as the std140Bench target.
+///
+/// Here's an example use case:
+
+/**
+// a few microseconds per glBufferSubData, a few GB/s across the bus : join gaps up to 4 KB
+std140::RangeCoalescer uploads = std140::RangeCoalescer::forBlock<PointLightUBO>(std140::UploadCost{ 1000.0, 0.25 });
+
+for (const std140::MemberRange& range : uploads.coalesce(lights.flush()))
+{
+    glBufferSubData(GL_UNIFORM_BUFFER, range.offset, range.size, lights.bytes() + range.offset);
+}
+**/
+
+namespace std140
+{
+    /// Cost of an upload in any unit, eg. nanoseconds : perCall + perByte * bytes
+    struct UploadCost
+    {
+        double perCall;
+        double perByte;
+
+        constexpr double of(std::size_t calls, std::size_t bytes) const
+        {
+            return perCall * double(calls) + perByte * double(bytes);
+        }
+
+        /// The widest gap cheaper to upload than to make another call for
+        constexpr std::size_t breakEvenGap() const
+        {
+            return perByte > 0.0 ? std::size_t(perCall / perByte) : std::size_t(-1);
+        }
+    };
+
+    struct UploadStats
+    {
+        std::size_t calls;
+        std::size_t bytes;
+    };
+
+    inline UploadStats uploadStats(const std::vector<MemberRange>& ranges)
+    {
+        UploadStats stats{ ranges.size(), 0 };
+
+        for (const MemberRange& range : ranges)
+        {
+            stats.bytes += range.size;
+        }
+
+        return stats;
+    }
+
+    namespace detail
+    {
+        template <typename T, std::size_t N>
+        constexpr void appendLeaves(std::array<MemberRange, N>& leaves, std::size_t& n, std::size_t offset)
+        {
+            typedef typename UnwrapArrayElement<T>::type U;
+
+            if constexpr (IsLeaf<U>::value)
+            {
+                leaves[n++] = MemberRange{ offset, spannedSize<U>() };
+            }
+            else if constexpr (IsArray<U>::value)
+            {
+                for (std::size_t i = 0; i < ArrayTraits<U>::Length; i++)
+                {
+                    appendLeaves<typename ArrayTraits<U>::AlignedType>(leaves, n, offset + i * ArrayTraits<U>::Stride);
+                }
+            }
+            else
+            {
+                forEachMember<U>([&](auto member)
+                {
+                    appendLeaves<typename decltype(member)::type>(leaves, n, offset + member.offset);
+                });
+            }
+        }
+    }
+
+    /// Every scalar, vector and matrix column of T with the bytes it covers, in offset order
+    template <typename T>
+    constexpr std::array<MemberRange, detail::leafCount<T>()> memberLeaves()
+    {
+        std::array<MemberRange, detail::leafCount<T>()> leaves{};
+        std::size_t n = 0;
+
+        detail::appendLeaves<T>(leaves, n, 0);
+        return leaves;
+    }
+
+    /// memberLeaves<T>() as a static table, for RangeCoalescer::forBlock
+    template <typename T>
+    inline constexpr auto MemberLeavesOf = memberLeaves<T>();
+
+    class RangeCoalescer
+    {
+    public:
+
+        /// leaves are the member boundaries to snap to, sorted by offset, and must outlive the coalescer. Without them ranges are taken as they are
+        explicit RangeCoalescer(UploadCost cost, const MemberRange* leaves = nullptr, std::size_t leafCount = 0)
+            : uploadCost(cost), gap(cost.breakEvenGap()), leaves(leaves), leafCount(leafCount)
+        {
+        }
+
+        template <typename T>
+        static RangeCoalescer forBlock(UploadCost cost)
+        {
+            return RangeCoalescer(cost, MemberLeavesOf<T>.data(), MemberLeavesOf<T>.size());
+        }
+
+        const UploadCost& cost() const { return uploadCost; }
+
+        std::size_t maxGap() const { return gap; }
+
+        /// Overrides the break even gap of the cost model
+        void setMaxGap(std::size_t bytes) { gap = bytes; }
+
+        /// The uploads covering the dirty ranges, in offset order. The list stays valid until the next call
+        const std::vector<MemberRange>& coalesce(const std::vector<MemberRange>& dirty)
+        {
+            return coalesce(dirty.data(), dirty.size());
+        }
+
+        const std::vector<MemberRange>& coalesce(const MemberRange* dirty, std::size_t count)
+        {
+            snapped.clear();
+
+            for (std::size_t i = 0; i < count; i++)
+            {
+                const MemberRange range = snap(dirty[i]);
+                if (range.size)
+                {
+                    snapped.push_back(range);
+                }
+            }
+
+            std::sort(snapped.begin(), snapped.end(), [](const MemberRange& a, const MemberRange& b) { return a.offset < b.offset; });
+
+            uploads.clear();
+
+            for (const MemberRange& range : snapped)
+            {
+                if (!uploads.empty())
+                {
+                    MemberRange& last = uploads.back();
+                    const std::size_t end = last.offset + last.size;
+
+                    if (range.offset <= end || range.offset - end <= gap)
+                    {
+                        last.size = std::max(end, range.offset + range.size) - last.offset;
+                        continue;
+                    }
+                }
+
+                uploads.push_back(range);
+            }
+
+            return uploads;
+        }
+
+    private:
+
+        /// Grows a range to whole members and trims the padding off its ends, empty if it only covers padding
+        MemberRange snap(const MemberRange& range) const
+        {
+            if (!leaves || !range.size)
+            {
+                return range;
+            }
+
+            const MemberRange* end = leaves + leafCount;
+            const auto byOffset = [](std::size_t offset, const MemberRange& leaf) { return offset < leaf.offset; };
+
+            // the first leaf ending after the range starts, and the last one starting before it ends
+            const MemberRange* first = std::upper_bound(leaves, end, range.offset, byOffset);
+            if (first != leaves && range.offset < (first - 1)->offset + (first - 1)->size)
+            {
+                first--;
+            }
+
+            const MemberRange* last = std::upper_bound(leaves, end, range.offset + range.size - 1, byOffset);
+
+            if (first == end || last == leaves || first >= last)
+            {
+                return MemberRange{ range.offset, 0 };
+            }
+
+            last--;
+            return MemberRange{ first->offset, last->offset + last->size - first->offset };
+        }
+
+        UploadCost uploadCost;
+        std::size_t gap;
+
+        const MemberRange* leaves;
+        std::size_t leafCount;
+
+        std::vector<MemberRange> snapped;
+        std::vector<MemberRange> uploads;
+    };
+}
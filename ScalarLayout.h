@@ -0,0 +1,186 @@
+#pragma once
+#include "Std140.h"
+
+/// Intro and Usage
+/// This header defines types for buffers declared with layout(scalar) from GL_EXT_scalar_block_layout
+/// It mirrors the vocabulary of Std140.h, so a struct written against std140:: can be moved to scalar:: by changing the namespace
+///
+/// The scalar layout drops the vector alignment rules entirely :
+///     a scalar is aligned to its size
+///     a vector or matrix is aligned to its component type, so a vec3 is 12 bytes with no padding
+///     matrix columns (or rows) are packed back to back
+///     an array is aligned to its element type, and its stride is the size of an element
+///     a struct is aligned to its largest member
+///
+/// These are the same rules the C++ compiler uses for plain structs, so an Array<vec3, N> has the same layout
+/// as a tightly packed float[N][3] on the host, and can be filled with one memcpy.
+///
+/// Here's an example use case:
+
+/**
+struct Vertex : public scalar::UBOStruct<>
+{
+    scalar::vec3 position;   // offset 0
+    scalar::vec3 normal;     // offset 12
+    scalar::vec2 uv;         // offset 24
+};
+
+struct MeshSSBO
+{
+    scalar::Array<scalar::vec3, 1024> positions; // stride 12
+    scalar::Array<Vertex, 1024> vertices;        // stride 32
+};
+**/
+
+namespace scalar
+{
+    // https://github.com/KhronosGroup/GLSL/blob/master/extensions/ext/GL_EXT_scalar_block_layout.txt
+
+    using std140::float32_t;
+    using std140::double64_t;
+    using std140::Bool32;
+    using std140::bool32_t;
+    using std140::int32_t;
+    using std140::uint32_t;
+
+    using std140::Vector;
+
+    template <typename P, int SZ>
+    struct VectorAlignment
+    {
+        const static std::size_t AlignmentValue = alignof(P);
+    };
+
+    // no ALIGN on these, the natural alignment of std::array<P, SZ> is already the alignment of P
+    typedef Vector<GLfloat, 2> vec2;
+    typedef Vector<GLfloat, 3> vec3;
+    typedef Vector<GLfloat, 4> vec4;
+
+    typedef Vector<Bool32, 2> bvec2;
+    typedef Vector<Bool32, 3> bvec3;
+    typedef Vector<Bool32, 4> bvec4;
+
+    typedef Vector<GLdouble, 2> dvec2;
+    typedef Vector<GLdouble, 3> dvec3;
+    typedef Vector<GLdouble, 4> dvec4;
+
+    typedef Vector<GLint, 2> ivec2;
+    typedef Vector<GLint, 3> ivec3;
+    typedef Vector<GLint, 4> ivec4;
+
+    typedef Vector<GLuint, 2> uvec2;
+    typedef Vector<GLuint, 3> uvec3;
+    typedef Vector<GLuint, 4> uvec4;
+
+    template <typename T>
+    struct ArrayAlignment
+    {
+        static constexpr std::size_t AlignmentValue = alignof(T);
+        typedef T ArrayAlignedType;
+    };
+
+    template <typename P, int SZ>
+    struct Array : public std::array<typename ArrayAlignment<P>::ArrayAlignedType, SZ> {};
+
+    template <typename P, int COLS, int ROWS, bool columnMajor = true>
+    struct Matrix : public Array< Vector<P, columnMajor ? ROWS : COLS>, columnMajor ? COLS : ROWS >
+    {
+    };
+
+    typedef Matrix<float, 2, 2> mat2;
+    typedef Matrix<float, 3, 3> mat3;
+    typedef Matrix<float, 4, 4> mat4;
+
+    typedef Matrix<float, 2, 3> mat2x3;
+    typedef Matrix<float, 2, 4> mat2x4;
+
+    typedef Matrix<float, 3, 2> mat3x2;
+    typedef Matrix<float, 3, 4> mat3x4;
+
+    typedef Matrix<float, 4, 2> mat4x2;
+    typedef Matrix<float, 4, 3> mat4x3;
+
+    typedef Matrix<double, 2, 2> dmat2;
+    typedef Matrix<double, 3, 3> dmat3;
+    typedef Matrix<double, 4, 4> dmat4;
+
+    typedef Matrix<double, 2, 3> dmat2x3;
+    typedef Matrix<double, 2, 4> dmat2x4;
+
+    typedef Matrix<double, 3, 2> dmat3x2;
+    typedef Matrix<double, 3, 4> dmat3x4;
+
+    typedef Matrix<double, 4, 2> dmat4x2;
+    typedef Matrix<double, 4, 3> dmat4x3;
+
+    /// A scalar struct is aligned to its largest member, which the compiler does on its own.
+    /// The template argument is kept so the declarations read the same as std140.
+    template <typename T = float32_t>
+    struct ALIGN(alignof(T)) UBOStruct
+    {
+    };
+
+    using std140::NoHeader;
+
+    /// Header plus unsized trailing array, using the scalar array rules. See std140::BasicRuntimeArray
+    template <typename HEADER, typename P, std::size_t HEADER_END = (std::is_empty<HEADER>::value ? 0 : sizeof(HEADER))>
+    using RuntimeArray = std140::BasicRuntimeArray<HEADER, typename ArrayAlignment<P>::ArrayAlignedType, HEADER_END>;
+
+    /// The scalar vocabulary as a template argument, see std140::Layout
+    struct Layout
+    {
+        typedef scalar::float32_t float32_t;
+        typedef scalar::double64_t double64_t;
+        typedef scalar::bool32_t bool32_t;
+        typedef scalar::int32_t int32_t;
+        typedef scalar::uint32_t uint32_t;
+
+        typedef scalar::vec2 vec2;
+        typedef scalar::vec3 vec3;
+        typedef scalar::vec4 vec4;
+
+        typedef scalar::bvec2 bvec2;
+        typedef scalar::bvec3 bvec3;
+        typedef scalar::bvec4 bvec4;
+
+        typedef scalar::dvec2 dvec2;
+        typedef scalar::dvec3 dvec3;
+        typedef scalar::dvec4 dvec4;
+
+        typedef scalar::ivec2 ivec2;
+        typedef scalar::ivec3 ivec3;
+        typedef scalar::ivec4 ivec4;
+
+        typedef scalar::uvec2 uvec2;
+        typedef scalar::uvec3 uvec3;
+        typedef scalar::uvec4 uvec4;
+
+        template <typename P, int SZ>
+        using Array = scalar::Array<P, SZ>;
+
+        template <typename P, int COLS, int ROWS, bool columnMajor = true>
+        using Matrix = scalar::Matrix<P, COLS, ROWS, columnMajor>;
+
+        typedef scalar::mat2 mat2;
+        typedef scalar::mat3 mat3;
+        typedef scalar::mat4 mat4;
+        typedef scalar::mat2x3 mat2x3;
+        typedef scalar::mat2x4 mat2x4;
+        typedef scalar::mat3x2 mat3x2;
+        typedef scalar::mat3x4 mat3x4;
+        typedef scalar::mat4x2 mat4x2;
+        typedef scalar::mat4x3 mat4x3;
+        typedef scalar::dmat2 dmat2;
+        typedef scalar::dmat3 dmat3;
+        typedef scalar::dmat4 dmat4;
+        typedef scalar::dmat2x3 dmat2x3;
+        typedef scalar::dmat2x4 dmat2x4;
+        typedef scalar::dmat3x2 dmat3x2;
+        typedef scalar::dmat3x4 dmat3x4;
+        typedef scalar::dmat4x2 dmat4x2;
+        typedef scalar::dmat4x3 dmat4x3;
+
+        template <typename T = scalar::float32_t>
+        using UBOStruct = scalar::UBOStruct<T>;
+    };
+}
@@ -0,0 +1,208 @@
+#pragma once
+#include "UBOReflection.h"
+#include <cstring>
+#include <vector>
+
+#if !defined(STD140_SHADOW_SCALAR) && (defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2))
+#include <immintrin.h>
+#define STD140_SHADOW_SIMD 1
+#endif
+
+/// Intro and Usage
+/// Dirty ranges for blocks written through plain references, where Tracked<> can't see the writes. A ShadowImage keeps a copy
+/// of the block as it was last uploaded, and diff() compares the block against it to find what changed since.
+///
+/// The comparison works in 16 byte slots. std140 never lets a vec3, vec4, matrix column, array element or struct straddle one
+/// (see Vec4Pack.h), so a changed slot is a whole set of changed members, and slots are the natural unit to upload.
+/// Slots are compared 16 bytes (SSE2) or 32 bytes (AVX2) at a time, 64 bytes per step while nothing differs, so the cost is close
+/// to streaming both copies through the cache once. A block whose size isn't a multiple of 16 has its tail compared with memcmp.
+///
+/// diff() returns the changed slots merged into ranges, and copies them into the shadow, so the ranges are taken as uploaded.
+/// They can go through a RangeCoalescer to trim them to members and join them under a cost model.
+///
+/// The SIMD path follows the compiler's target : AVX2 when __AVX2__ is defined (eg. -mavx2, /arch:AVX2), otherwise SSE2 on any x86-64.
+/// Define STD140_SHADOW_SCALAR to use the portable loop everywhere.
+///
+/// Here's an example use case:
+
+/**
+PointLightUBO lights;                                   // written all over the code base
+std140::Shadow<PointLightUBO> uploaded;                 // starts dirty, the first diff is the whole block
+
+// per frame
+for (const std140::MemberRange& range : uploaded.diff(lights))
+{
+    glBufferSubData(GL_UNIFORM_BUFFER, range.offset, range.size, reinterpret_cast<const char*>(&lights) + range.offset);
+}
+**/
+
+namespace std140
+{
+    static constexpr std::size_t ShadowSlotSize = 16u;
+
+    namespace detail
+    {
+        /// True if the 64 bytes at a and b are equal
+        inline bool shadowEqual64(const unsigned char* a, const unsigned char* b)
+        {
+#if defined(STD140_SHADOW_SIMD) && defined(__AVX2__)
+            const __m256i lo = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b)));
+            const __m256i hi = _mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + 32)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 32)));
+            return _mm256_movemask_epi8(_mm256_and_si256(lo, hi)) == -1;
+#elif defined(STD140_SHADOW_SIMD)
+            __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b)));
+
+            for (std::size_t i = 16; i < 64; i += 16)
+            {
+                equal = _mm_and_si128(equal, _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + i)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + i))));
+            }
+
+            return _mm_movemask_epi8(equal) == 0xFFFF;
+#else
+            return std::memcmp(a, b, 64) == 0;
+#endif
+        }
+
+        /// One bit per 16 byte slot of the 64 bytes at a and b, set where the slot differs
+        inline unsigned shadowChangedSlots64(const unsigned char* a, const unsigned char* b)
+        {
+#if defined(STD140_SHADOW_SIMD) && defined(__AVX2__)
+            const unsigned lo = unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b)))));
+            const unsigned hi = unsigned(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_loadu_si256(reinterpret_cast<const __m256i*>(a + 32)), _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b + 32)))));
+
+            return unsigned((lo & 0xFFFFu) != 0xFFFFu) | (unsigned((lo >> 16) != 0xFFFFu) << 1) |
+                (unsigned((hi & 0xFFFFu) != 0xFFFFu) << 2) | (unsigned((hi >> 16) != 0xFFFFu) << 3);
+#elif defined(STD140_SHADOW_SIMD)
+            unsigned changed = 0;
+
+            for (unsigned slot = 0; slot < 4; slot++)
+            {
+                const __m128i equal = _mm_cmpeq_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(a + slot * 16)), _mm_loadu_si128(reinterpret_cast<const __m128i*>(b + slot * 16)));
+                changed |= unsigned(_mm_movemask_epi8(equal) != 0xFFFF) << slot;
+            }
+
+            return changed;
+#else
+            unsigned changed = 0;
+
+            for (unsigned slot = 0; slot < 4; slot++)
+            {
+                changed |= unsigned(std::memcmp(a + slot * 16, b + slot * 16, 16) != 0) << slot;
+            }
+
+            return changed;
+#endif
+        }
+    }
+
+    /// The last uploaded bytes of a block of a size known at run time
+    class ShadowImage
+    {
+    public:
+
+        /// The shadow starts out of date, so the first diff() returns the whole block
+        explicit ShadowImage(std::size_t bytes) : image(bytes, 0), stale(true)
+        {
+        }
+
+        std::size_t size() const { return image.size(); }
+
+        const unsigned char* bytes() const { return image.data(); }
+
+        /// Makes the next diff() return the whole block, eg. after the buffer was recreated
+        void invalidate() { stale = true; }
+
+        /// The ranges of block that changed since the last diff, in 16 byte slots, merged where they touch. The list stays valid until the next call
+        const std::vector<MemberRange>& diff(const void* block)
+        {
+            const unsigned char* current = static_cast<const unsigned char*>(block);
+            const std::size_t bytes = image.size();
+
+            ranges.clear();
+
+            if (stale)
+            {
+                std::memcpy(image.data(), current, bytes);
+                stale = false;
+
+                if (bytes)
+                {
+                    ranges.push_back(MemberRange{ 0, bytes });
+                }
+                return ranges;
+            }
+
+            const std::size_t blocks = bytes / 64 * 64;
+            std::size_t offset = 0;
+
+            for (; offset < blocks; offset += 64)
+            {
+                if (detail::shadowEqual64(current + offset, image.data() + offset))
+                {
+                    continue;
+                }
+
+                const unsigned changed = detail::shadowChangedSlots64(current + offset, image.data() + offset);
+
+                for (unsigned slot = 0; slot < 4; slot++)
+                {
+                    if (changed & (1u << slot))
+                    {
+                        addSlot(offset + slot * ShadowSlotSize, ShadowSlotSize);
+                    }
+                }
+            }
+
+            for (; offset < bytes; offset += ShadowSlotSize)
+            {
+                const std::size_t size = bytes - offset < ShadowSlotSize ? bytes - offset : ShadowSlotSize;
+
+                if (std::memcmp(current + offset, image.data() + offset, size) != 0)
+                {
+                    addSlot(offset, size);
+                }
+            }
+
+            for (const MemberRange& range : ranges)
+            {
+                std::memcpy(image.data() + range.offset, current + range.offset, range.size);
+            }
+
+            return ranges;
+        }
+
+    private:
+
+        void addSlot(std::size_t offset, std::size_t size)
+        {
+            if (!ranges.empty() && ranges.back().offset + ranges.back().size == offset)
+            {
+                ranges.back().size += size;
+            }
+            else
+            {
+                ranges.push_back(MemberRange{ offset, size });
+            }
+        }
+
+        std::vector<unsigned char> image;
+        std::vector<MemberRange> ranges;
+        bool stale;
+    };
+
+    /// A ShadowImage sized for T
+    template <typename T>
+    class Shadow : public ShadowImage
+    {
+    public:
+
+        Shadow() : ShadowImage(sizeof(T))
+        {
+        }
+
+        const std::vector<MemberRange>& diff(const T& block)
+        {
+            return ShadowImage::diff(&block);
+        }
+    };
+}
@@ -1,5 +1,9 @@
 #pragma once
 #include <array>
+#include <cstring>
+#include <new>
+#include <type_traits>
+#include <utility>
 
 /// Intro and Usage
 /// This header defines types you can use to define UBO's in the std140 memory layout in the client code
@@ -11,7 +15,7 @@
 /// 
 /// We have primitive types that just map to the corresponding OpenGL typedefs
 ///     double64_t; 
-///     bool32_t;
+///     bool32_t;     (a 4 byte Bool32, like GLSL, rather than the 1 byte GLboolean)
 ///     int32_t;
 ///     uint32_t;
 ///     float32_t
@@ -137,9 +141,24 @@ namespace std140
         T* data() { return &value; }
     };
 
+    /// GLSL stores a bool as a 32 bit word, where GLboolean is 1 byte, so a GLboolean member would leave 3 bytes of garbage in the block.
+    /// Bool32 is the whole word with bool semantics : zero is false, anything else is true, and true is stored as 1.
+    /// It starts out false, like the other AlignedPrimitiveType array elements start out 0.
+    struct Bool32
+    {
+        GLuint value = 0u;
+
+        Bool32() = default;
+        constexpr Bool32(bool b) : value(b ? 1u : 0u) {}
+
+        constexpr Bool32& operator=(bool b) { value = b ? 1u : 0u; return *this; }
+
+        constexpr operator bool() const { return value != 0u; }
+    };
+
     typedef ALIGN(4) GLfloat float32_t;
     typedef ALIGN(8) GLdouble double64_t;
-    typedef ALIGN(4) GLboolean bool32_t;
+    typedef ALIGN(4) Bool32 bool32_t;
     typedef ALIGN(4) GLint int32_t;
     typedef ALIGN(4) GLuint uint32_t;
 
@@ -155,9 +174,9 @@ namespace std140
     typedef ALIGN((VectorAlignment<GLfloat, 3>::AlignmentValue)) Vector<GLfloat, 3> vec3;
     typedef ALIGN((VectorAlignment<GLfloat, 4>::AlignmentValue)) Vector<GLfloat, 4> vec4;
     
-    typedef ALIGN((VectorAlignment<GLboolean, 2>::AlignmentValue)) Vector<GLboolean, 2> bvec2;
-    typedef ALIGN((VectorAlignment<GLfloat, 3>::AlignmentValue)) Vector<GLboolean, 3> bvec3;
-    typedef ALIGN((VectorAlignment<GLfloat, 4>::AlignmentValue)) Vector<GLboolean, 4> bvec4;
+    typedef ALIGN((VectorAlignment<Bool32, 2>::AlignmentValue)) Vector<Bool32, 2> bvec2;
+    typedef ALIGN((VectorAlignment<Bool32, 3>::AlignmentValue)) Vector<Bool32, 3> bvec3;
+    typedef ALIGN((VectorAlignment<Bool32, 4>::AlignmentValue)) Vector<Bool32, 4> bvec4;
 
     typedef ALIGN((VectorAlignment<GLdouble, 2>::AlignmentValue)) Vector<GLdouble, 2> dvec2;
     typedef ALIGN((VectorAlignment<GLdouble, 3>::AlignmentValue)) Vector<GLdouble, 3> dvec3;
@@ -178,6 +197,15 @@ namespace std140
         typedef ArrayAlignedStruct<T, AlignmentValue> ArrayAlignedType;
     };
 
+    // vectors pick up their alignment from the typedef, which is lost when they are used as a template argument (Array<dvec3>,
+    // and the columns of every Matrix), so recover it here. dvec3 and dvec4 elements are then 32 byte aligned, as the spec has them
+    template <typename P, int SZ>
+    struct ArrayAlignment<Vector<P, SZ> >
+    {
+        static constexpr std::size_t AlignmentValue = std::max<std::size_t>(alignof(vec4), VectorAlignment<P, SZ>::AlignmentValue);
+        typedef ArrayAlignedStruct<Vector<P, SZ>, AlignmentValue> ArrayAlignedType;
+    };
+
     template<>
     struct ArrayAlignment<std140::float32_t>
     {
@@ -195,8 +223,9 @@ namespace std140
     template<>
     struct ArrayAlignment<std140::bool32_t>
     {
-        static constexpr std::size_t AlignmentValue = std::max<std::size_t>(alignof(vec4), alignof(GLboolean));
-        typedef AlignedPrimitiveType<GLboolean, AlignmentValue> ArrayAlignedType;
+        static constexpr std::size_t AlignmentValue = std::max<std::size_t>(alignof(vec4), alignof(Bool32));
+        // Bool32 is a class, so array elements derive from it and keep its conversions to and from bool
+        typedef ArrayAlignedStruct<Bool32, AlignmentValue> ArrayAlignedType;
     };
 
 
@@ -258,5 +287,191 @@ namespace std140
     struct ALIGN(AlignOrVec4Align<T>())  UBOStruct
     {
     };
-}
 
+    /// Placeholder header for shader storage blocks that contain nothing but the unsized array
+    struct NoHeader
+    {
+    };
+
+    /// Shader storage blocks can end in an unsized array, eg.
+    ///     buffer ParticleBlock { int nParticles; Particle particles[]; };
+    /// The length of that array is picked at run time, so it can't be a member of a C++ struct.
+    /// BasicRuntimeArray owns a single allocation of exactly ArrayOffset + n * ElementStride bytes holding the header followed by n elements,
+    /// so the whole block can still be uploaded with one memcpy or BufferSubData.
+    ///
+    /// ALIGNED_TYPE is the array element type after the layout's ArrayAlignment has been applied, use the RuntimeArray aliases rather than this directly.
+    /// HEADER_END is where the last member of the header ends, it defaults to sizeof(HEADER).
+    /// That is only wrong when HEADER has tail padding the first array element could be packed into (eg. a trailing vec3 before a std430 float array),
+    /// in which case pass offsetof(HEADER, lastMember) + sizeof(lastMember)
+    template <typename HEADER, typename ALIGNED_TYPE, std::size_t HEADER_END = (std::is_empty<HEADER>::value ? 0 : sizeof(HEADER))>
+    class BasicRuntimeArray
+    {
+    public:
+
+        typedef HEADER header_type;
+        typedef ALIGNED_TYPE value_type;
+
+        static constexpr std::size_t ArrayAlignmentValue = alignof(ALIGNED_TYPE);
+        static constexpr std::size_t ElementStride = sizeof(ALIGNED_TYPE);
+        static constexpr std::size_t ArrayOffset = (HEADER_END + ArrayAlignmentValue - 1) / ArrayAlignmentValue * ArrayAlignmentValue;
+        static constexpr std::size_t StorageAlignment = alignof(HEADER) > ArrayAlignmentValue ? alignof(HEADER) : ArrayAlignmentValue;
+
+        static_assert(std::is_trivially_copyable<HEADER>::value && std::is_trivially_copyable<ALIGNED_TYPE>::value,
+            "the block is uploaded as raw bytes, so the header and elements must be trivially copyable");
+
+        /// total size in bytes of a block holding count elements
+        static constexpr std::size_t byteSize(std::size_t count) { return ArrayOffset + count * ElementStride; }
+
+        BasicRuntimeArray() = default;
+
+        explicit BasicRuntimeArray(std::size_t count)
+        {
+            resize(count);
+        }
+
+        BasicRuntimeArray(BasicRuntimeArray&& other) noexcept
+            : storage(other.storage), count(other.count)
+        {
+            other.storage = nullptr;
+            other.count = 0;
+        }
+
+        BasicRuntimeArray& operator=(BasicRuntimeArray&& other) noexcept
+        {
+            std::swap(storage, other.storage);
+            std::swap(count, other.count);
+            return *this;
+        }
+
+        // copying millions of elements by accident is never what you want
+        BasicRuntimeArray(const BasicRuntimeArray&) = delete;
+        BasicRuntimeArray& operator=(const BasicRuntimeArray&) = delete;
+
+        ~BasicRuntimeArray()
+        {
+            release(storage);
+        }
+
+        /// Reallocates to exactly byteSize(newCount) bytes, keeping the header and the first min(size(), newCount) elements
+        void resize(std::size_t newCount)
+        {
+            unsigned char* newStorage = static_cast<unsigned char*>(::operator new(byteSize(newCount), std::align_val_t(StorageAlignment)));
+
+            if (!std::is_empty<HEADER>::value)
+            {
+                new (newStorage) HEADER();
+            }
+
+            for (std::size_t i = 0; i < newCount; i++)
+            {
+                new (newStorage + ArrayOffset + i * ElementStride) ALIGNED_TYPE();
+            }
+
+            if (storage)
+            {
+                std::memcpy(newStorage, storage, byteSize(count < newCount ? count : newCount));
+                release(storage);
+            }
+
+            storage = newStorage;
+            count = newCount;
+        }
+
+        HEADER& header() { return *reinterpret_cast<HEADER*>(storage); }
+        const HEADER& header() const { return *reinterpret_cast<const HEADER*>(storage); }
+
+        ALIGNED_TYPE& operator[](std::size_t i) { return *reinterpret_cast<ALIGNED_TYPE*>(storage + ArrayOffset + i * ElementStride); }
+        const ALIGNED_TYPE& operator[](std::size_t i) const { return *reinterpret_cast<const ALIGNED_TYPE*>(storage + ArrayOffset + i * ElementStride); }
+
+        ALIGNED_TYPE* begin() { return &(*this)[0]; }
+        ALIGNED_TYPE* end() { return &(*this)[0] + count; }
+        const ALIGNED_TYPE* begin() const { return &(*this)[0]; }
+        const ALIGNED_TYPE* end() const { return &(*this)[0] + count; }
+
+        std::size_t size() const { return count; }
+
+        /// pointer to the whole block, header first, for memcpy / BufferSubData
+        const void* data() const { return storage; }
+        void* data() { return storage; }
+
+        std::size_t byteSize() const { return storage ? byteSize(count) : 0; }
+
+    private:
+
+        static void release(unsigned char* ptr)
+        {
+            if (ptr)
+            {
+                ::operator delete(ptr, std::align_val_t(StorageAlignment));
+            }
+        }
+
+        unsigned char* storage = nullptr;
+        std::size_t count = 0;
+    };
+
+    /// Header plus unsized trailing array, using the std140 array rules. 
+    /// Eg. RuntimeArray<NoHeader, PointLight> lights(n); or RuntimeArray<ParticleHeader, Particle> particles(n);
+    template <typename HEADER, typename P, std::size_t HEADER_END = (std::is_empty<HEADER>::value ? 0 : sizeof(HEADER))>
+    using RuntimeArray = BasicRuntimeArray<HEADER, typename ArrayAlignment<P>::ArrayAlignedType, HEADER_END>;
+
+    /// Bundles the std140 vocabulary into one type, so a block can be declared once as a template over the layout, eg.
+    ///     template <typename L> struct Light : public L::template UBOStruct<> { typename L::vec3 direction; typename L::float32_t intensity; };
+    /// and instantiated as Light<std140::Layout>, Light<std430::Layout>, Light<scalar::Layout>
+    struct Layout
+    {
+        typedef std140::float32_t float32_t;
+        typedef std140::double64_t double64_t;
+        typedef std140::bool32_t bool32_t;
+        typedef std140::int32_t int32_t;
+        typedef std140::uint32_t uint32_t;
+
+        typedef std140::vec2 vec2;
+        typedef std140::vec3 vec3;
+        typedef std140::vec4 vec4;
+
+        typedef std140::bvec2 bvec2;
+        typedef std140::bvec3 bvec3;
+        typedef std140::bvec4 bvec4;
+
+        typedef std140::dvec2 dvec2;
+        typedef std140::dvec3 dvec3;
+        typedef std140::dvec4 dvec4;
+
+        typedef std140::ivec2 ivec2;
+        typedef std140::ivec3 ivec3;
+        typedef std140::ivec4 ivec4;
+
+        typedef std140::uvec2 uvec2;
+        typedef std140::uvec3 uvec3;
+        typedef std140::uvec4 uvec4;
+
+        template <typename P, int SZ>
+        using Array = std140::Array<P, SZ>;
+
+        template <typename P, int COLS, int ROWS, bool columnMajor = true>
+        using Matrix = std140::Matrix<P, COLS, ROWS, columnMajor>;
+
+        typedef std140::mat2 mat2;
+        typedef std140::mat3 mat3;
+        typedef std140::mat4 mat4;
+        typedef std140::mat2x3 mat2x3;
+        typedef std140::mat2x4 mat2x4;
+        typedef std140::mat3x2 mat3x2;
+        typedef std140::mat3x4 mat3x4;
+        typedef std140::mat4x2 mat4x2;
+        typedef std140::mat4x3 mat4x3;
+        typedef std140::dmat2 dmat2;
+        typedef std140::dmat3 dmat3;
+        typedef std140::dmat4 dmat4;
+        typedef std140::dmat2x3 dmat2x3;
+        typedef std140::dmat2x4 dmat2x4;
+        typedef std140::dmat3x2 dmat3x2;
+        typedef std140::dmat3x4 dmat3x4;
+        typedef std140::dmat4x2 dmat4x2;
+        typedef std140::dmat4x3 dmat4x3;
+
+        template <typename T = std140::vec4>
+        using UBOStruct = std140::UBOStruct<T>;
+    };
+}
@@ -0,0 +1,191 @@
+#pragma once
+#include "Std140.h"
+
+/// Intro and Usage
+/// This header defines types you can use to define shader storage blocks in the std430 memory layout in the client code
+/// It mirrors the vocabulary of Std140.h, so a struct written against std140:: can be moved to std430:: by changing the namespace
+///
+/// std430 differs from std140 only in the array and struct rules :
+///     the base alignment and stride of an array is NOT rounded up to the alignment of a vec4
+///     the base alignment of a struct is NOT rounded up to the alignment of a vec4
+///
+/// So a float[N] costs 4 bytes per element instead of 16, and a vec2[N] costs 8 instead of 16.
+/// Scalars and vectors have the same alignment in both layouts, so those types are shared with std140
+///
+/// std430 is only available to shader storage blocks (and push constants in Vulkan), uniform blocks must still use std140
+///
+/// Here's an example use case:
+
+/**
+struct Particle : public std430::UBOStruct<>
+{
+    std430::vec3 position;
+    std430::float32_t age;
+    std430::vec2 uv;
+};
+
+struct ParticleSSBO
+{
+    std430::Array<std430::float32_t, 16> weights;  // 64 bytes, would be 256 in std140
+    std430::Array<Particle, 1024> particles;
+};
+**/
+
+namespace std430
+{
+    // https://www.khronos.org/registry/OpenGL/specs/gl/glspec45.core.pdf#page=159
+    // "When using the std430 storage layout, shader storage blocks will be laid out in buffer storage identically to uniform and shader storage blocks
+    //  using the std140 layout, except that the base alignment and stride of arrays of scalars and vectors in rule 4 and of structures in rule 9
+    //  are not rounded up a multiple of the base alignment of a vec4."
+
+    using std140::float32_t;
+    using std140::double64_t;
+    using std140::bool32_t;
+    using std140::int32_t;
+    using std140::uint32_t;
+
+    using std140::Vector;
+
+    using std140::vec2;
+    using std140::vec3;
+    using std140::vec4;
+
+    using std140::bvec2;
+    using std140::bvec3;
+    using std140::bvec4;
+
+    using std140::dvec2;
+    using std140::dvec3;
+    using std140::dvec4;
+
+    using std140::ivec2;
+    using std140::ivec3;
+    using std140::ivec4;
+
+    using std140::uvec2;
+    using std140::uvec3;
+    using std140::uvec4;
+
+    // scalars and structs already have the correct size and alignment for std430, so array elements of those types are stored as is
+    template <typename T>
+    struct ArrayAlignment
+    {
+        static constexpr std::size_t AlignmentValue = alignof(T);
+        typedef T ArrayAlignedType;
+    };
+
+    // vectors pick up their alignment from the typedef, which is lost when they are used as a template argument
+    // so recover it here. vec3 arrays still have a 16 byte stride, same as std140
+    template <typename P, int SZ>
+    struct ArrayAlignment<std140::Vector<P, SZ> >
+    {
+        static constexpr std::size_t AlignmentValue = std140::VectorAlignment<P, SZ>::AlignmentValue;
+        typedef std140::ArrayAlignedStruct<std140::Vector<P, SZ>, AlignmentValue> ArrayAlignedType;
+    };
+
+    template <typename P, int SZ>
+    struct Array : public std::array<typename ArrayAlignment<P>::ArrayAlignedType, SZ> {};
+
+    // matrices are stored as arrays of column (or row) vectors, so in std430 a mat2 is 16 bytes rather than 32
+    template <typename P, int COLS, int ROWS, bool columnMajor = true>
+    struct Matrix : public Array< Vector<P, columnMajor ? ROWS : COLS>, columnMajor ? COLS : ROWS >
+    {
+    };
+
+    typedef Matrix<float, 2, 2> mat2;
+    typedef Matrix<float, 3, 3> mat3;
+    typedef Matrix<float, 4, 4> mat4;
+
+    typedef Matrix<float, 2, 3> mat2x3;
+    typedef Matrix<float, 2, 4> mat2x4;
+
+    typedef Matrix<float, 3, 2> mat3x2;
+    typedef Matrix<float, 3, 4> mat3x4;
+
+    typedef Matrix<float, 4, 2> mat4x2;
+    typedef Matrix<float, 4, 3> mat4x3;
+
+    typedef Matrix<double, 2, 2> dmat2;
+    typedef Matrix<double, 3, 3> dmat3;
+    typedef Matrix<double, 4, 4> dmat4;
+
+    typedef Matrix<double, 2, 3> dmat2x3;
+    typedef Matrix<double, 2, 4> dmat2x4;
+
+    typedef Matrix<double, 3, 2> dmat3x2;
+    typedef Matrix<double, 3, 4> dmat3x4;
+
+    typedef Matrix<double, 4, 2> dmat4x2;
+    typedef Matrix<double, 4, 3> dmat4x3;
+
+    /// In std430 the base alignment of a struct is the alignment of its largest member, which is exactly what the C++ compiler does for us.
+    /// The template argument is kept so the declarations read the same as std140, and can force a larger alignment if you really want one.
+    template <typename T = float32_t>
+    struct ALIGN(alignof(T)) UBOStruct
+    {
+    };
+
+    using std140::NoHeader;
+
+    /// Header plus unsized trailing array, using the std430 array rules. See std140::BasicRuntimeArray
+    template <typename HEADER, typename P, std::size_t HEADER_END = (std::is_empty<HEADER>::value ? 0 : sizeof(HEADER))>
+    using RuntimeArray = std140::BasicRuntimeArray<HEADER, typename ArrayAlignment<P>::ArrayAlignedType, HEADER_END>;
+
+    /// The std430 vocabulary as a template argument, see std140::Layout
+    struct Layout
+    {
+        typedef std430::float32_t float32_t;
+        typedef std430::double64_t double64_t;
+        typedef std430::bool32_t bool32_t;
+        typedef std430::int32_t int32_t;
+        typedef std430::uint32_t uint32_t;
+
+        typedef std430::vec2 vec2;
+        typedef std430::vec3 vec3;
+        typedef std430::vec4 vec4;
+
+        typedef std430::bvec2 bvec2;
+        typedef std430::bvec3 bvec3;
+        typedef std430::bvec4 bvec4;
+
+        typedef std430::dvec2 dvec2;
+        typedef std430::dvec3 dvec3;
+        typedef std430::dvec4 dvec4;
+
+        typedef std430::ivec2 ivec2;
+        typedef std430::ivec3 ivec3;
+        typedef std430::ivec4 ivec4;
+
+        typedef std430::uvec2 uvec2;
+        typedef std430::uvec3 uvec3;
+        typedef std430::uvec4 uvec4;
+
+        template <typename P, int SZ>
+        using Array = std430::Array<P, SZ>;
+
+        template <typename P, int COLS, int ROWS, bool columnMajor = true>
+        using Matrix = std430::Matrix<P, COLS, ROWS, columnMajor>;
+
+        typedef std430::mat2 mat2;
+        typedef std430::mat3 mat3;
+        typedef std430::mat4 mat4;
+        typedef std430::mat2x3 mat2x3;
+        typedef std430::mat2x4 mat2x4;
+        typedef std430::mat3x2 mat3x2;
+        typedef std430::mat3x4 mat3x4;
+        typedef std430::mat4x2 mat4x2;
+        typedef std430::mat4x3 mat4x3;
+        typedef std430::dmat2 dmat2;
+        typedef std430::dmat3 dmat3;
+        typedef std430::dmat4 dmat4;
+        typedef std430::dmat2x3 dmat2x3;
+        typedef std430::dmat2x4 dmat2x4;
+        typedef std430::dmat3x2 dmat3x2;
+        typedef std430::dmat3x4 dmat3x4;
+        typedef std430::dmat4x2 dmat4x2;
+        typedef std430::dmat4x3 dmat4x3;
+
+        template <typename T = std430::float32_t>
+        using UBOStruct = std430::UBOStruct<T>;
+    };
+}
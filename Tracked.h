@@ -0,0 +1,163 @@
+#pragma once
+#include "UBOReflection.h"
+#include <algorithm>
+#include <cassert>
+#include <vector>
+
+/// Intro and Usage
+/// A block that remembers which of its bytes were written since the last upload, so a frame where one light of 25 moved
+/// uploads that light, not the whole block.
+///
+/// Tracked<T> owns a T. Reads go through get() or ->, writes through edit() or set(), which take the member being written
+/// (any nested member, Array<> element or Matrix column of the block) and record the bytes it covers before handing it out.
+/// A member listed with UBO_MEMBERS covers its values only, so editing a vec3 doesn't dirty the float packed into its tail.
+/// markDirty() takes a range directly, eg. one from range_of<T>() worked out at compile time.
+///
+/// A new Tracked<T> is all dirty, like a freshly created buffer is all undefined.
+/// flush() sorts and merges what was recorded into the fewest ranges covering it, and starts over. Ranges closer together than
+/// the gap passed to it are joined, trading a few clean bytes for fewer upload calls.
+///
+/// Here's an example use case:
+
+/**
+std140::Tracked<PointLightUBO> lights;
+
+// per frame
+lights.edit(lights->pointLights[3].location) = { { x, y, z } };
+lights.set(lights->nPointLights, 4);
+
+for (const std140::MemberRange& range : lights.flush(16))
+{
+    glBufferSubData(GL_UNIFORM_BUFFER, range.offset, range.size, lights.bytes() + range.offset);
+}
+**/
+
+namespace std140
+{
+    namespace detail
+    {
+        /// Bytes of a member a write dirties : its values for anything reflection can walk, all of it otherwise
+        template <typename M>
+        constexpr std::size_t trackedSize()
+        {
+            typedef typename UnwrapArrayElement<M>::type U;
+
+            if constexpr (IsLeaf<U>::value || IsArray<U>::value || HasMembers<U>::value)
+            {
+                return spannedSize<U>();
+            }
+            else
+            {
+                return sizeof(M);
+            }
+        }
+    }
+
+    template <typename T>
+    class Tracked
+    {
+    public:
+
+        /// Starts dirty, so the first flush() covers the whole block and a new buffer's undefined contents are all replaced
+        Tracked() : value()
+        {
+            markAll();
+        }
+
+        explicit Tracked(const T& value) : value(value)
+        {
+            markAll();
+        }
+
+        const T& get() const { return value; }
+        const T* operator->() const { return &value; }
+
+        const unsigned char* bytes() const { return reinterpret_cast<const unsigned char*>(&value); }
+
+        /// The member, writable, after marking it dirty. member must be a part of get()
+        template <typename M>
+        M& edit(const M& member)
+        {
+            const std::size_t offset = reinterpret_cast<const unsigned char*>(&member) - bytes();
+
+            assert(offset + sizeof(M) <= sizeof(T) && "the member isn't part of this block");
+
+            markDirty(offset, detail::trackedSize<M>());
+            return const_cast<M&>(member);
+        }
+
+        template <typename M, typename V>
+        void set(const M& member, const V& v)
+        {
+            edit(member) = v;
+        }
+
+        /// Replaces the whole block
+        void set(const T& v)
+        {
+            value = v;
+            markAll();
+        }
+
+        void markDirty(std::size_t offset, std::size_t size)
+        {
+            // consecutive writes to neighbouring members are common, and are merged here so the list stays short between flushes
+            if (!pending.empty() && offset <= pending.back().offset + pending.back().size && pending.back().offset <= offset + size)
+            {
+                MemberRange& last = pending.back();
+                const std::size_t end = std::max(last.offset + last.size, offset + size);
+
+                last.offset = std::min(last.offset, offset);
+                last.size = end - last.offset;
+                return;
+            }
+
+            pending.push_back(MemberRange{ offset, size });
+        }
+
+        void markDirty(const MemberRange& range)
+        {
+            assert(range.valid());
+            markDirty(range.offset, range.size);
+        }
+
+        void markAll()
+        {
+            pending.clear();
+            pending.push_back(MemberRange{ 0, sizeof(T) });
+        }
+
+        bool dirty() const { return !pending.empty(); }
+
+        /// The dirty ranges, sorted and merged, ranges up to gap bytes apart into one. The list stays valid until the next flush
+        const std::vector<MemberRange>& flush(std::size_t gap = 0)
+        {
+            std::sort(pending.begin(), pending.end(), [](const MemberRange& a, const MemberRange& b) { return a.offset < b.offset; });
+
+            flushed.clear();
+
+            for (const MemberRange& range : pending)
+            {
+                if (!flushed.empty() && range.offset <= flushed.back().offset + flushed.back().size + gap)
+                {
+                    MemberRange& last = flushed.back();
+                    last.size = std::max(last.offset + last.size, range.offset + range.size) - last.offset;
+                }
+                else
+                {
+                    flushed.push_back(range);
+                }
+            }
+
+            pending.clear();
+            return flushed;
+        }
+
+    private:
+
+        T value{};
+
+        std::vector<MemberRange> pending;
+        std::vector<MemberRange> flushed;
+    };
+}
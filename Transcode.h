@@ -0,0 +1,208 @@
+#pragma once
+#include "UBOMembers.h"
+#include <cstring>
+
+/// Intro and Usage
+/// A block declared once as a template over the layout (see std140::Layout) can be instantiated in several layouts,
+/// eg. a tightly packed scalar::Layout copy for the host side, and a std140::Layout copy only at upload time.
+///
+/// Transcoder<Src, Dst> converts between two instantiations of the same block.
+/// The copy plan is worked out at compile time by walking both member lists (UBO_MEMBERS) side by side down to scalars and vectors,
+/// and merging every value that is contiguous in both layouts into one run. At run time the copy is just a fixed list of memcpy's.
+/// eg. a float[16] going from std430 to scalar is one 64 byte run, while a vec3[16] going from std140 to scalar is 16 runs of 12 bytes.
+///
+/// Here's an example use case:
+
+/**
+template <typename L>
+struct Light : public L::template UBOStruct<>
+{
+    typename L::vec3 direction;
+    typename L::float32_t intensity;
+    typename L::template Array<typename L::vec4, 4> shadowSplits;
+
+    UBO_MEMBERS(Light, direction, intensity, shadowSplits)
+};
+
+Light<scalar::Layout> hostLight;
+Light<std140::Layout> uploadLight;
+
+std140::transcode(hostLight, uploadLight);
+**/
+
+namespace std140
+{
+    /// One memcpy of the plan
+    struct CopyRun
+    {
+        std::size_t src;
+        std::size_t dst;
+        std::size_t size;
+    };
+
+    template <std::size_t CAPACITY>
+    struct CopyPlan
+    {
+        std::array<CopyRun, CAPACITY> runs{};
+        std::size_t count = 0;
+
+        constexpr void append(std::size_t src, std::size_t dst, std::size_t size)
+        {
+            if (count)
+            {
+                CopyRun& last = runs[count - 1];
+
+                if (last.src + last.size == src && last.dst + last.size == dst)
+                {
+                    last.size += size;
+                    return;
+                }
+            }
+
+            runs[count++] = CopyRun{ src, dst, size };
+        }
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        constexpr std::size_t leafCount()
+        {
+            typedef typename UnwrapArrayElement<T>::type U;
+
+            if constexpr (IsLeaf<U>::value)
+            {
+                return 1;
+            }
+            else if constexpr (IsArray<U>::value)
+            {
+                return ArrayTraits<U>::Length * leafCount<typename ArrayTraits<U>::AlignedType>();
+            }
+            else
+            {
+                static_assert(HasMembers<U>::value, "list the members of nested structs with UBO_MEMBERS");
+
+                std::size_t count = 0;
+                forEachMember<U>([&count](auto member) { count += leafCount<typename decltype(member)::type>(); });
+                return count;
+            }
+        }
+
+        template <typename S, typename D, typename Plan, std::size_t... I>
+        constexpr void appendMemberRuns(Plan& plan, std::size_t srcOffset, std::size_t dstOffset, std::index_sequence<I...>);
+
+        template <typename S, typename D, typename Plan>
+        constexpr void appendRuns(Plan& plan, std::size_t srcOffset, std::size_t dstOffset)
+        {
+            typedef typename UnwrapArrayElement<S>::type US;
+            typedef typename UnwrapArrayElement<D>::type UD;
+
+            if constexpr (IsLeaf<US>::value)
+            {
+                static_assert(IsLeaf<UD>::value && std::is_same<typename ComponentType<US>::type, typename ComponentType<UD>::type>::value && ValueSize<US>::value == ValueSize<UD>::value,
+                    "transcoding only moves values between layouts, both sides need the same scalar or vector type");
+
+                plan.append(srcOffset, dstOffset, ValueSize<US>::value);
+            }
+            else if constexpr (IsArray<US>::value)
+            {
+                static_assert(IsArray<UD>::value && ArrayTraits<US>::Length == ArrayTraits<UD>::Length, "array lengths differ between layouts");
+
+                for (std::size_t i = 0; i < ArrayTraits<US>::Length; i++)
+                {
+                    appendRuns<typename ArrayTraits<US>::AlignedType, typename ArrayTraits<UD>::AlignedType>(plan,
+                        srcOffset + i * ArrayTraits<US>::Stride, dstOffset + i * ArrayTraits<UD>::Stride);
+                }
+            }
+            else
+            {
+                static_assert(memberCount<US>() == memberCount<UD>(), "member lists differ between layouts");
+
+                appendMemberRuns<US, UD>(plan, srcOffset, dstOffset, std::make_index_sequence<memberCount<US>()>());
+            }
+        }
+
+        template <typename S, typename D, typename Plan, std::size_t... I>
+        constexpr void appendMemberRuns(Plan& plan, std::size_t srcOffset, std::size_t dstOffset, std::index_sequence<I...>)
+        {
+            constexpr auto srcMembers = S::uboMembers();
+            constexpr auto dstMembers = D::uboMembers();
+
+            (appendRuns<typename std::tuple_element<I, decltype(srcMembers)>::type::type, typename std::tuple_element<I, decltype(dstMembers)>::type::type>(plan,
+                srcOffset + std::get<I>(srcMembers).offset, dstOffset + std::get<I>(dstMembers).offset), ...);
+        }
+
+        template <typename S, typename D>
+        constexpr CopyPlan<leafCount<S>()> makeCopyPlan()
+        {
+            CopyPlan<leafCount<S>()> plan;
+            appendRuns<S, D>(plan, 0, 0);
+            return plan;
+        }
+    }
+
+    /// Copies between two layouts of the same block with a precomputed list of coalesced memcpy runs
+    template <typename S, typename D>
+    struct Transcoder
+    {
+        static constexpr std::size_t RunCount = detail::makeCopyPlan<S, D>().count;
+
+        static constexpr std::array<CopyRun, RunCount> makeRuns()
+        {
+            constexpr auto plan = detail::makeCopyPlan<S, D>();
+
+            std::array<CopyRun, RunCount> runs{};
+            for (std::size_t i = 0; i < RunCount; i++)
+            {
+                runs[i] = plan.runs[i];
+            }
+            return runs;
+        }
+
+        static constexpr std::array<CopyRun, RunCount> Runs = makeRuns();
+
+        /// Bytes actually copied, ie. the bytes that aren't padding in either layout
+        static constexpr std::size_t copiedBytes()
+        {
+            std::size_t total = 0;
+            for (const CopyRun& run : Runs)
+            {
+                total += run.size;
+            }
+            return total;
+        }
+
+        static void copy(const S& src, D& dst)
+        {
+            copyRuns(reinterpret_cast<const unsigned char*>(&src), reinterpret_cast<unsigned char*>(&dst), std::integral_constant<bool, (RunCount <= 64)>());
+        }
+
+    private:
+
+        // short plans are unrolled so every memcpy has a constant size and offset and compiles down to a few moves
+        static void copyRuns(const unsigned char* src, unsigned char* dst, std::true_type)
+        {
+            copyUnrolled(src, dst, std::make_index_sequence<RunCount>());
+        }
+
+        static void copyRuns(const unsigned char* src, unsigned char* dst, std::false_type)
+        {
+            for (const CopyRun& run : Runs)
+            {
+                std::memcpy(dst + run.dst, src + run.src, run.size);
+            }
+        }
+
+        template <std::size_t... I>
+        static void copyUnrolled(const unsigned char* src, unsigned char* dst, std::index_sequence<I...>)
+        {
+            (std::memcpy(dst + Runs[I].dst, src + Runs[I].src, Runs[I].size), ...);
+        }
+    };
+
+    template <typename S, typename D>
+    void transcode(const S& src, D& dst)
+    {
+        Transcoder<S, D>::copy(src, dst);
+    }
+}
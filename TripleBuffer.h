@@ -0,0 +1,106 @@
+#pragma once
+#include <atomic>
+#include <cstdint>
+
+/// Intro and Usage
+/// Hands blocks from a thread producing them (simulation) to a thread uploading them (render) without a lock.
+///
+/// TripleBuffer<T> keeps three copies of T : one the writer is filling, one the reader is using, and the latest complete one
+/// in between. publish() swaps the writer's copy with the one in between, and acquire() swaps the one in between with the reader's,
+/// if it's newer. Each is a single atomic exchange, so neither thread ever waits on the other : the writer can publish faster than
+/// the reader acquires (frames in between are dropped, the reader always gets the latest), and the reader can acquire more often than
+/// the writer publishes (it keeps the frame it has).
+///
+/// The copy the writer gets after publish() holds an older frame, not the one just published, so it has to be written in full,
+/// or filled with publish(const T&). There must be one writer thread and one reader thread.
+///
+/// Each copy sits on its own cache lines, so the two threads don't slow each other down through false sharing.
+///
+/// test/bench.cpp (the std140Bench target) compares it against a block guarded by a mutex, under contention.
+///
+/// Here's an example use case:
+
+/**
+std140::TripleBuffer<CameraUBO> camera;
+
+// simulation thread
+camera.write().viewProjection = ...;
+camera.publish();
+
+// render thread
+if (camera.acquire())
+{
+    upload(camera.read());
+}
+**/
+
+namespace std140
+{
+    template <typename T>
+    class TripleBuffer
+    {
+    public:
+
+        TripleBuffer() = default;
+
+        explicit TripleBuffer(const T& initial)
+        {
+            for (Slot& slot : slots)
+            {
+                slot.value = initial;
+            }
+        }
+
+        TripleBuffer(const TripleBuffer&) = delete;
+        TripleBuffer& operator=(const TripleBuffer&) = delete;
+
+        /// The writer's copy, to fill before publish()
+        T& write() { return slots[writeIndex].value; }
+
+        /// Makes the writer's copy the latest complete frame
+        void publish()
+        {
+            // release, so the reader that picks the index up sees everything written to the copy
+            writeIndex = middle.exchange(std::uint8_t(writeIndex | Fresh), std::memory_order_acq_rel) & IndexMask;
+        }
+
+        void publish(const T& block)
+        {
+            write() = block;
+            publish();
+        }
+
+        /// Takes the latest published frame for read(), if there is one newer than it already has. False if not
+        bool acquire()
+        {
+            if (!(middle.load(std::memory_order_relaxed) & Fresh))
+            {
+                return false;
+            }
+
+            readIndex = middle.exchange(readIndex, std::memory_order_acq_rel) & IndexMask;
+            return true;
+        }
+
+        /// The reader's copy, the frame last acquired
+        const T& read() const { return slots[readIndex].value; }
+
+    private:
+
+        static constexpr std::uint8_t IndexMask = 3;
+        static constexpr std::uint8_t Fresh = 4;
+
+        struct alignas(64) Slot
+        {
+            T value{};
+        };
+
+        Slot slots[3];
+
+        // the middle copy's index and whether it's newer than the reader's, alone on its cache line
+        alignas(64) std::atomic<std::uint8_t> middle{ 1 };
+
+        alignas(64) std::uint8_t writeIndex = 0;
+        alignas(64) std::uint8_t readIndex = 2;
+    };
+}
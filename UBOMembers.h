@@ -0,0 +1,291 @@
+#pragma once
+#include "Std140.h"
+#include <cstddef>
+#include <tuple>
+
+/// Intro and Usage
+/// C++ has no way to enumerate the members of a struct, so blocks that want to be walked generically (transcoded between layouts, reflected, etc.)
+/// list their members once with UBO_MEMBERS inside the struct body.
+///
+/// UBO_MEMBERS(Type, a, b, c) defines
+///     static constexpr const char* uboName()     the name of the struct
+///     static constexpr auto uboMembers()         a std::tuple of std140::Member<decltype(a)>, ... holding the name and offsetof of each member
+///
+/// Everything is constexpr, so code walking the members is resolved at compile time.
+///
+/// Here's an example use case:
+
+/**
+struct DirectionalLight : public std140::UBOStruct<>
+{
+    std140::vec3 direction;
+    std140::vec3 color;
+
+    UBO_MEMBERS(DirectionalLight, direction, color)
+};
+**/
+
+namespace std140
+{
+    /// One listed member of a block : its type, name and byte offset within the block
+    template <typename T>
+    struct Member
+    {
+        typedef T type;
+
+        const char* name;
+        std::size_t offset;
+    };
+
+    template <typename T, typename = void>
+    struct HasMembers : std::false_type {};
+
+    template <typename T>
+    struct HasMembers<T, decltype((void)T::uboMembers())> : std::true_type {};
+
+    template <typename T>
+    constexpr std::size_t memberCount()
+    {
+        return std::tuple_size<decltype(T::uboMembers())>::value;
+    }
+
+    namespace detail
+    {
+        template <typename P, int SZ>
+        std::true_type isVector(const Vector<P, SZ>*);
+        std::false_type isVector(...);
+
+        template <typename E, std::size_t SZ>
+        std::true_type isStdArray(const std::array<E, SZ>*);
+        std::false_type isStdArray(...);
+
+        template <typename E, std::size_t SZ>
+        std::array<E, SZ> asStdArray(const std::array<E, SZ>*);
+
+        template <typename Tuple, typename F, std::size_t... I>
+        constexpr void forEachMemberImpl(const Tuple& members, F&& f, std::index_sequence<I...>)
+        {
+            (f(std::get<I>(members)), ...);
+        }
+    }
+
+    /// Vector<P, SZ>, or anything derived from it (like msl::Vector3)
+    template <typename T>
+    struct IsVector : decltype(detail::isVector(static_cast<T*>(nullptr))) {};
+
+    /// Array<>s and Matrix types, anything derived from std::array that isn't a vector
+    template <typename T>
+    struct IsArray : std::integral_constant<bool, decltype(detail::isStdArray(static_cast<T*>(nullptr)))::value && !IsVector<T>::value> {};
+
+    /// Arithmetic types and Bool32
+    template <typename T>
+    struct IsScalar : std::integral_constant<bool, std::is_arithmetic<T>::value || std::is_same<T, Bool32>::value> {};
+
+    /// Scalars and vectors, the values member walks bottom out at
+    template <typename T>
+    struct IsLeaf : std::integral_constant<bool, IsScalar<T>::value || IsVector<T>::value> {};
+
+    /// Component type of a scalar or vector
+    template <typename T, typename = void>
+    struct ComponentType
+    {
+        typedef T type;
+    };
+
+    template <typename T>
+    struct ComponentType<T, typename std::enable_if<IsVector<T>::value>::type>
+    {
+        typedef typename T::value_type type;
+    };
+
+    /// Bytes of a scalar or vector that hold data, ie. without the padding a typedef alignment or Vector3 adds
+    template <typename T, typename = void>
+    struct ValueSize
+    {
+        static constexpr std::size_t value = sizeof(T);
+    };
+
+    template <typename T>
+    struct ValueSize<T, typename std::enable_if<IsVector<T>::value>::type>
+    {
+        static constexpr std::size_t value = T::length() * sizeof(typename T::value_type);
+    };
+
+    /// Element type and length of an Array<> or Matrix
+    template <typename T>
+    struct ArrayTraits
+    {
+        typedef decltype(detail::asStdArray(static_cast<T*>(nullptr))) StdArray;
+        typedef typename StdArray::value_type AlignedType;
+
+        static constexpr std::size_t Length = std::tuple_size<StdArray>::value;
+        static constexpr std::size_t Stride = sizeof(AlignedType);
+    };
+
+    /// Strips the ArrayAlignment wrapper from an array element. The wrapped value always sits at offset 0 of the wrapper.
+    template <typename T>
+    struct UnwrapArrayElement
+    {
+        typedef T type;
+    };
+
+    template <typename T, std::size_t A>
+    struct UnwrapArrayElement<ArrayAlignedStruct<T, A> >
+    {
+        typedef T type;
+    };
+
+    template <typename T, std::size_t A>
+    struct UnwrapArrayElement<AlignedPrimitiveType<T, A> >
+    {
+        typedef T type;
+    };
+
+    /// Shape of a Matrix type. Each layout's Matrix is its own template, so each layout specializes this for its own
+    template <typename T>
+    struct MatrixTraits
+    {
+        static constexpr bool IsMatrix = false;
+    };
+
+    template <typename P, int COLS, int ROWS, bool columnMajor>
+    struct MatrixTraits<Matrix<P, COLS, ROWS, columnMajor> >
+    {
+        static constexpr bool IsMatrix = true;
+        static constexpr int Columns = COLS;
+        static constexpr int Rows = ROWS;
+        static constexpr bool ColumnMajor = columnMajor;
+        typedef P Component;
+    };
+
+    /// GLSL name of a scalar type
+    template <typename P>
+    constexpr const char* glslComponentName()
+    {
+        if constexpr (std::is_same<P, GLfloat>::value)
+        {
+            return "float";
+        }
+        else if constexpr (std::is_same<P, GLdouble>::value)
+        {
+            return "double";
+        }
+        else if constexpr (std::is_same<P, GLint>::value)
+        {
+            return "int";
+        }
+        else if constexpr (std::is_same<P, GLuint>::value)
+        {
+            return "uint";
+        }
+        else
+        {
+            static_assert(std::is_same<P, Bool32>::value, "no GLSL type for this component type");
+            return "bool";
+        }
+    }
+
+    /// GLSL name of a member type : "float", "ivec3", "mat3x2", or the uboName() of a struct.
+    /// For arrays it is the name of the element type, the length is ArrayTraits<T>::Length
+    template <typename T>
+    constexpr const char* glslTypeName()
+    {
+        typedef typename UnwrapArrayElement<T>::type U;
+
+        if constexpr (MatrixTraits<U>::IsMatrix)
+        {
+            constexpr const char* names[2][3][3] =
+            {
+                { { "mat2", "mat2x3", "mat2x4" }, { "mat3x2", "mat3", "mat3x4" }, { "mat4x2", "mat4x3", "mat4" } },
+                { { "dmat2", "dmat2x3", "dmat2x4" }, { "dmat3x2", "dmat3", "dmat3x4" }, { "dmat4x2", "dmat4x3", "dmat4" } }
+            };
+
+            return names[std::is_same<typename MatrixTraits<U>::Component, GLdouble>::value ? 1 : 0][MatrixTraits<U>::Columns - 2][MatrixTraits<U>::Rows - 2];
+        }
+        else if constexpr (IsArray<U>::value)
+        {
+            return glslTypeName<typename ArrayTraits<U>::AlignedType>();
+        }
+        else if constexpr (IsVector<U>::value)
+        {
+            typedef typename U::value_type P;
+
+            constexpr const char* names[5][3] =
+            {
+                { "vec2", "vec3", "vec4" },
+                { "dvec2", "dvec3", "dvec4" },
+                { "ivec2", "ivec3", "ivec4" },
+                { "uvec2", "uvec3", "uvec4" },
+                { "bvec2", "bvec3", "bvec4" }
+            };
+
+            constexpr const char* component = glslComponentName<P>();
+            constexpr int kind = component[0] == 'f' ? 0 : component[0] == 'd' ? 1 : component[0] == 'i' ? 2 : component[0] == 'u' ? 3 : 4;
+
+            return names[kind][U::length() - 2];
+        }
+        else if constexpr (IsScalar<U>::value)
+        {
+            return glslComponentName<U>();
+        }
+        else
+        {
+            return U::uboName();
+        }
+    }
+
+    /// Calls f(member) for every Member<> listed by T's UBO_MEMBERS
+    template <typename T, typename F>
+    constexpr void forEachMember(F&& f)
+    {
+        detail::forEachMemberImpl(T::uboMembers(), f, std::make_index_sequence<memberCount<T>()>());
+    }
+}
+
+/// Preprocessor helpers to apply a macro to each member name
+
+#define UBO_PP_EXPAND(x) x
+#define UBO_PP_CAT_(a, b) a##b
+#define UBO_PP_CAT(a, b) UBO_PP_CAT_(a, b)
+#define UBO_PP_NARGS_(_1, _2, _3, _4, _5, _6, _7, _8, _9, _10, _11, _12, _13, _14, _15, _16, _17, _18, _19, _20, _21, _22, _23, _24, _25, _26, _27, _28, _29, _30, _31, _32, N, ...) N
+#define UBO_PP_NARGS(...) UBO_PP_EXPAND(UBO_PP_NARGS_(__VA_ARGS__, 32, 31, 30, 29, 28, 27, 26, 25, 24, 23, 22, 21, 20, 19, 18, 17, 16, 15, 14, 13, 12, 11, 10, 9, 8, 7, 6, 5, 4, 3, 2, 1))
+#define UBO_PP_MAP(M, T, ...) UBO_PP_EXPAND(UBO_PP_CAT(UBO_PP_MAP_, UBO_PP_NARGS(__VA_ARGS__))(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_1(M, T, x) M(T, x)
+#define UBO_PP_MAP_2(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_1(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_3(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_2(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_4(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_3(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_5(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_4(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_6(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_5(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_7(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_6(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_8(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_7(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_9(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_8(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_10(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_9(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_11(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_10(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_12(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_11(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_13(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_12(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_14(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_13(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_15(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_14(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_16(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_15(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_17(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_16(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_18(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_17(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_19(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_18(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_20(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_19(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_21(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_20(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_22(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_21(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_23(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_22(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_24(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_23(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_25(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_24(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_26(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_25(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_27(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_26(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_28(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_27(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_29(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_28(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_30(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_29(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_31(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_30(M, T, __VA_ARGS__))
+#define UBO_PP_MAP_32(M, T, x, ...) M(T, x), UBO_PP_EXPAND(UBO_PP_MAP_31(M, T, __VA_ARGS__))
+
+#define UBO_MEMBER_ENTRY(TYPE, NAME) ::std140::Member<decltype(TYPE::NAME)>{ #NAME, offsetof(TYPE, NAME) }
+
+/// Lists the members of a block, in declaration order. Use inside the struct body, after the members.
+#define UBO_MEMBERS(TYPE, ...) \
+    static constexpr const char* uboName() { return #TYPE; } \
+    static constexpr auto uboMembers() { return std::make_tuple(UBO_PP_MAP(UBO_MEMBER_ENTRY, TYPE, __VA_ARGS__)); }
@@ -0,0 +1,302 @@
+#pragma once
+#include "UBOMembers.h"
+#include "Std430.h"
+#include "ScalarLayout.h"
+#include "MslLayout.h"
+#include <string_view>
+
+/// Intro and Usage
+/// A constexpr table describing the members of a block, built from its UBO_MEMBERS list.
+/// Each entry holds what the GL reflection queries would return for the member (offset, GLSL type, array length and stride, matrix stride and majorness)
+/// plus its size in bytes, so upload, diff and validation code can be written once and run over any block, with the table folded away at compile time.
+///
+/// reflect<T>() is the table of the direct members of T. Members of struct type are described by reflect<> of that struct, found with MemberType.
+/// offset_of<T>("a[1].b") and range_of<T>() resolve a path through nested members, Array<> elements and Matrix columns.
+///
+/// Here's an example use case:
+
+/**
+struct Light : public std140::UBOStruct<>
+{
+    std140::vec3 direction;
+    std140::float32_t intensity;
+    std140::Array<std140::mat4, 4> shadowMatrices;
+
+    UBO_MEMBERS(Light, direction, intensity, shadowMatrices)
+};
+
+constexpr auto lightTable = std140::reflect<Light>();
+
+static_assert(lightTable[1].offset == 12, "");
+static_assert(lightTable[2].arrayLength == 4 && lightTable[2].arrayStride == 64 && lightTable[2].matrixStride == 16, "");
+
+for (const std140::MemberInfo& member : lightTable)
+{
+    std::cout << member.glslType << " " << member.name << " at " << member.offset << std::endl;
+}
+**/
+
+namespace std140
+{
+    // the matrices of the other layouts are distinct templates, so reflection needs to be told they are matrices too
+
+    template <typename P, int COLS, int ROWS, bool columnMajor>
+    struct MatrixTraits<std430::Matrix<P, COLS, ROWS, columnMajor> > : MatrixTraits<Matrix<P, COLS, ROWS, columnMajor> > {};
+
+    template <typename P, int COLS, int ROWS, bool columnMajor>
+    struct MatrixTraits<scalar::Matrix<P, COLS, ROWS, columnMajor> > : MatrixTraits<Matrix<P, COLS, ROWS, columnMajor> > {};
+
+    template <typename P, int COLS, int ROWS, bool columnMajor>
+    struct MatrixTraits<msl::Matrix<P, COLS, ROWS, columnMajor> > : MatrixTraits<Matrix<P, COLS, ROWS, columnMajor> > {};
+
+    enum class MemberKind
+    {
+        Scalar,
+        Vector,
+        Matrix,
+        Struct
+    };
+
+    /// One row of the reflection table. For arrays, kind and glslType describe the element.
+    struct MemberInfo
+    {
+        const char* name;
+        std::size_t offset;
+        std::size_t size;           // bytes the member spans, without the padding of a trailing vec3 or struct alignment
+        const char* glslType;
+        MemberKind kind;
+        std::size_t arrayLength;    // 0 if the member isn't an array
+        std::size_t arrayStride;    // GL_UNIFORM_ARRAY_STRIDE, 0 if the member isn't an array
+        std::size_t matrixStride;   // GL_UNIFORM_MATRIX_STRIDE, 0 if the member isn't a matrix
+        bool rowMajor;              // GL_UNIFORM_IS_ROW_MAJOR
+    };
+
+    /// The element type of an array member, or the member type itself
+    template <typename T, typename = void>
+    struct MemberType
+    {
+        typedef typename UnwrapArrayElement<T>::type type;
+    };
+
+    template <typename T>
+    struct MemberType<T, typename std::enable_if<IsArray<typename UnwrapArrayElement<T>::type>::value && !MatrixTraits<typename UnwrapArrayElement<T>::type>::IsMatrix>::type>
+    {
+        typedef typename MemberType<typename ArrayTraits<typename UnwrapArrayElement<T>::type>::AlignedType>::type type;
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        constexpr MemberKind memberKind()
+        {
+            if constexpr (MatrixTraits<T>::IsMatrix)
+            {
+                return MemberKind::Matrix;
+            }
+            else if constexpr (IsVector<T>::value)
+            {
+                return MemberKind::Vector;
+            }
+            else if constexpr (IsScalar<T>::value)
+            {
+                return MemberKind::Scalar;
+            }
+            else
+            {
+                return MemberKind::Struct;
+            }
+        }
+
+        /// Bytes from the start of T to the end of its last value
+        template <typename T>
+        constexpr std::size_t spannedSize()
+        {
+            typedef typename UnwrapArrayElement<T>::type U;
+
+            if constexpr (IsLeaf<U>::value)
+            {
+                return ValueSize<U>::value;
+            }
+            else if constexpr (IsArray<U>::value)
+            {
+                return (ArrayTraits<U>::Length - 1) * ArrayTraits<U>::Stride + spannedSize<typename ArrayTraits<U>::AlignedType>();
+            }
+            else
+            {
+                std::size_t end = 0;
+                forEachMember<U>([&end](auto member)
+                {
+                    const std::size_t memberEnd = member.offset + spannedSize<typename decltype(member)::type>();
+                    end = memberEnd > end ? memberEnd : end;
+                });
+                return end;
+            }
+        }
+
+        template <typename M>
+        constexpr MemberInfo memberInfo(const char* name, std::size_t offset)
+        {
+            typedef typename UnwrapArrayElement<M>::type U;
+            typedef typename MemberType<U>::type E;
+
+            MemberInfo info{ name, offset, spannedSize<U>(), glslTypeName<U>(), memberKind<E>(), 0, 0, 0, false };
+
+            if constexpr (IsArray<U>::value && !MatrixTraits<U>::IsMatrix)
+            {
+                info.arrayLength = ArrayTraits<U>::Length;
+                info.arrayStride = ArrayTraits<U>::Stride;
+            }
+
+            if constexpr (MatrixTraits<E>::IsMatrix)
+            {
+                info.matrixStride = ArrayTraits<E>::Stride;
+                info.rowMajor = !MatrixTraits<E>::ColumnMajor;
+            }
+
+            return info;
+        }
+    }
+
+    /// The reflection table of T, one entry per UBO_MEMBERS member in declaration order
+    template <typename T>
+    constexpr std::array<MemberInfo, memberCount<T>()> reflect()
+    {
+        std::array<MemberInfo, memberCount<T>()> table{};
+        std::size_t i = 0;
+
+        forEachMember<T>([&](auto member)
+        {
+            table[i++] = detail::memberInfo<typename decltype(member)::type>(member.name, member.offset);
+        });
+
+        return table;
+    }
+
+    namespace detail
+    {
+        constexpr bool namesEqual(const char* a, const char* b)
+        {
+            while (*a && *a == *b)
+            {
+                a++;
+                b++;
+            }
+            return *a == *b;
+        }
+    }
+
+    /// Index of the member called name in reflect<T>(), or memberCount<T>() if there is none
+    template <typename T>
+    constexpr std::size_t memberIndex(const char* name)
+    {
+        constexpr auto table = reflect<T>();
+
+        for (std::size_t i = 0; i < table.size(); i++)
+        {
+            if (detail::namesEqual(table[i].name, name))
+            {
+                return i;
+            }
+        }
+
+        return table.size();
+    }
+
+    /// Bytes a member path covers within a block, see range_of(). offset is npos if the path doesn't resolve
+    struct MemberRange
+    {
+        static constexpr std::size_t npos = std::size_t(-1);
+
+        std::size_t offset;
+        std::size_t size;       // from the offset to the end of the last value, like MemberInfo::size
+
+        constexpr bool valid() const { return offset != npos; }
+    };
+
+    namespace detail
+    {
+        template <typename T>
+        constexpr MemberRange resolvePath(std::string_view path, std::size_t offset);
+
+        /// path starts with the name of a member of T
+        template <typename T>
+        constexpr MemberRange resolveMember(std::string_view path, std::size_t offset)
+        {
+            typedef typename UnwrapArrayElement<T>::type U;
+
+            MemberRange range{ MemberRange::npos, 0 };
+
+            if constexpr (HasMembers<U>::value)
+            {
+                std::size_t end = 0;
+                while (end < path.size() && path[end] != '.' && path[end] != '[')
+                {
+                    end++;
+                }
+
+                const std::string_view name = path.substr(0, end);
+
+                forEachMember<U>([&](auto member)
+                {
+                    if (name == member.name)
+                    {
+                        range = resolvePath<typename decltype(member)::type>(path.substr(end), offset + member.offset);
+                    }
+                });
+            }
+
+            return range;
+        }
+
+        /// path is what follows a value of type T : empty, ".member" or "[index]" and more
+        template <typename T>
+        constexpr MemberRange resolvePath(std::string_view path, std::size_t offset)
+        {
+            typedef typename UnwrapArrayElement<T>::type U;
+
+            if (path.empty())
+            {
+                return MemberRange{ offset, spannedSize<U>() };
+            }
+
+            if (path[0] == '.')
+            {
+                return resolveMember<U>(path.substr(1), offset);
+            }
+
+            // Array<> elements, and the columns of a Matrix (its rows, if row major)
+            if constexpr (IsArray<U>::value)
+            {
+                std::size_t index = 0;
+                std::size_t i = 1;
+
+                for (; i < path.size() && path[i] >= '0' && path[i] <= '9'; i++)
+                {
+                    index = index * 10 + std::size_t(path[i] - '0');
+                }
+
+                if (path[0] == '[' && i > 1 && i < path.size() && path[i] == ']' && index < ArrayTraits<U>::Length)
+                {
+                    return resolvePath<typename ArrayTraits<U>::AlignedType>(path.substr(i + 1), offset + index * ArrayTraits<U>::Stride);
+                }
+            }
+
+            return MemberRange{ MemberRange::npos, 0 };
+        }
+    }
+
+    /// Offset and size of a member of T by path, eg. range_of<PointLightUBO>("pointLights[1].location"), through nested structs,
+    /// Array<> elements and Matrix columns. Every struct on the way needs UBO_MEMBERS. Invalid if the path doesn't resolve
+    template <typename T>
+    constexpr MemberRange range_of(std::string_view path)
+    {
+        return detail::resolveMember<T>(path, 0);
+    }
+
+    /// Byte offset of a member of T by path, the constexpr counterpart of &block.a[1].b - &block. MemberRange::npos if the path doesn't resolve
+    template <typename T>
+    constexpr std::size_t offset_of(std::string_view path)
+    {
+        return range_of<T>(path).offset;
+    }
+}
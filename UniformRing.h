@@ -0,0 +1,359 @@
+#pragma once
+#include <chrono>
+#include <cstring>
+#include <deque>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+/// Intro and Usage
+/// Per draw or per frame blocks written straight into a persistently mapped uniform buffer, as Std140.h suggests, without
+/// overwriting memory the GPU may still be reading.
+///
+/// UniformRing hands out slots from one mapped buffer, front to back and around, each aligned to GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT
+/// (and at least to the block's own alignment), so a slot can be bound with glBindBufferRange as is. endFrame() puts a fence
+/// after the frame's commands. Space a frame used is reused once its fence has signaled. When the ring runs into a frame whose fence
+/// hasn't, the allocation waits on it, and the wait is counted in stats() as a stall : a ring that stalls is too small for the
+/// frames in flight.
+///
+/// The buffer and fences come from a backend, with this interface :
+///     typedef ... Fence;
+///     unsigned char* memory();                the mapped buffer
+///     std::size_t size() const;
+///     std::size_t offsetAlignment() const;
+///     Fence fence();                          after the commands issued so far
+///     bool signaled(Fence);                   without blocking
+///     void wait(Fence);                       blocking
+///     void release(Fence);
+///
+/// GLRingBackend is a GL 4.4 persistent, coherent buffer with sync objects. MockRingBackend is plain memory with a simulated GPU
+/// that finishes each fence a set number of frames after it was issued, so the ring can be tested and benchmarked without a context.
+///
+/// Here's an example use case:
+
+/**
+std140::UniformRing<std140::GLRingBackend> ring(4 * 1024 * 1024);
+
+// per draw
+const auto slot = ring.push(objectBlock);
+glBindBufferRange(GL_UNIFORM_BUFFER, 1, ring.backend().buffer(), slot.offset, sizeof(ObjectUBO));
+
+// after the frame's draws
+ring.endFrame();
+**/
+
+namespace std140
+{
+    /// A block of type T in the ring : where to write it, and its byte offset in the buffer for glBindBufferRange
+    template <typename T>
+    struct RingSlot
+    {
+        T* block;
+        std::size_t offset;
+
+        bool valid() const { return block != nullptr; }
+    };
+
+    struct UniformRingStats
+    {
+        std::size_t frames = 0;
+        std::size_t allocations = 0;
+        std::size_t bytes = 0;          // handed out, without alignment padding
+        std::size_t paddingBytes = 0;   // spent on alignment and on skipping the end of the ring
+        std::size_t failed = 0;         // larger than the ring could ever hold at once
+        std::size_t stalls = 0;         // allocations that waited on a fence
+        std::chrono::nanoseconds stallTime{ 0 };
+    };
+
+    template <typename Backend>
+    class UniformRing
+    {
+    public:
+
+        typedef typename Backend::Fence Fence;
+
+        /// The backend is constructed from the arguments, eg. UniformRing<GLRingBackend> ring(bytes)
+        template <typename... Args>
+        explicit UniformRing(Args&&... args) : ringBackend(std::forward<Args>(args)...)
+        {
+        }
+
+        UniformRing(const UniformRing&) = delete;
+        UniformRing& operator=(const UniformRing&) = delete;
+
+        ~UniformRing()
+        {
+            for (const Frame& frame : frames)
+            {
+                ringBackend.release(frame.fence);
+            }
+        }
+
+        Backend& backend() { return ringBackend; }
+
+        const UniformRingStats& stats() const { return ringStats; }
+
+        void resetStats() { ringStats = UniformRingStats(); }
+
+        /// Frames ended whose fences haven't been seen to signal
+        std::size_t framesInFlight() const { return frames.size(); }
+
+        /// Room for a T, uninitialized. Invalid if a T doesn't fit beside the current frame's other allocations
+        template <typename T>
+        RingSlot<T> allocate()
+        {
+            static_assert(std::is_trivially_copyable<T>::value, "ring slots are raw memory the GPU reads, T has to be memcpy-able");
+
+            const std::size_t alignment = ringBackend.offsetAlignment() > alignof(T) ? ringBackend.offsetAlignment() : alignof(T);
+            const std::size_t offset = allocate(sizeof(T), alignment);
+
+            if (offset == npos)
+            {
+                return RingSlot<T>{ nullptr, 0 };
+            }
+
+            return RingSlot<T>{ reinterpret_cast<T*>(ringBackend.memory() + offset), offset };
+        }
+
+        /// A slot holding a copy of block
+        template <typename T>
+        RingSlot<T> push(const T& block)
+        {
+            const RingSlot<T> slot = allocate<T>();
+
+            if (slot.valid())
+            {
+                std::memcpy(static_cast<void*>(slot.block), &block, sizeof(T));
+            }
+
+            return slot;
+        }
+
+        /// Fences the frame's allocations, which are reused once the GPU is done with them
+        void endFrame()
+        {
+            frames.push_back(Frame{ ringBackend.fence(), head });
+            frameStart = head;
+            ringStats.frames++;
+
+            retire(false);
+        }
+
+    private:
+
+        static constexpr std::size_t npos = std::size_t(-1);
+
+        struct Frame
+        {
+            Fence fence;
+            unsigned long long end;     // head when the frame ended
+        };
+
+        /// Byte offset into the buffer of bytes aligned to alignment, or npos
+        std::size_t allocate(std::size_t bytes, std::size_t alignment)
+        {
+            const std::size_t size = ringBackend.size();
+
+            // head and tail count every byte ever handed out, so the used space is head - tail even across the end of the ring
+            const std::size_t position = std::size_t(head % size);
+            std::size_t offset = (position + alignment - 1) / alignment * alignment;
+
+            if (offset + bytes > size)
+            {
+                offset = 0;
+            }
+
+            const std::size_t skipped = offset >= position ? offset - position : size - position;
+            const unsigned long long newHead = head + skipped + bytes;
+
+            if (bytes > size || newHead - frameStart > size)
+            {
+                ringStats.failed++;
+                return npos;
+            }
+
+            if (newHead - tail > size)
+            {
+                retire(false);
+
+                if (newHead - tail > size)
+                {
+                    const auto start = std::chrono::steady_clock::now();
+
+                    while (newHead - tail > size)
+                    {
+                        retire(true);
+                    }
+
+                    ringStats.stalls++;
+                    ringStats.stallTime += std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start);
+                }
+            }
+
+            head = newHead;
+            ringStats.allocations++;
+            ringStats.bytes += bytes;
+            ringStats.paddingBytes += skipped;
+
+            return offset;
+        }
+
+        /// Frees the frames whose fences have signaled, in order. With wait, blocks on the oldest frame first
+        void retire(bool wait)
+        {
+            if (wait && !frames.empty())
+            {
+                ringBackend.wait(frames.front().fence);
+                release();
+            }
+
+            while (!frames.empty() && ringBackend.signaled(frames.front().fence))
+            {
+                release();
+            }
+        }
+
+        void release()
+        {
+            ringBackend.release(frames.front().fence);
+            tail = frames.front().end;
+            frames.pop_front();
+        }
+
+        Backend ringBackend;
+
+        std::deque<Frame> frames;
+        unsigned long long head = 0;
+        unsigned long long tail = 0;
+        unsigned long long frameStart = 0;   // head when the current frame began
+
+        UniformRingStats ringStats;
+    };
+
+    /// Plain memory, and a GPU that finishes each fence latency frames after it was issued, or when waited on
+    class MockRingBackend
+    {
+    public:
+
+        typedef unsigned long long Fence;
+
+        explicit MockRingBackend(std::size_t size, std::size_t offsetAlignment = 256, std::size_t latency = 2)
+            : buffer(size / 16 + 1), bytes(size), alignment(offsetAlignment), latency(latency)
+        {
+        }
+
+        unsigned char* memory() { return reinterpret_cast<unsigned char*>(buffer.data()); }
+        std::size_t size() const { return bytes; }
+        std::size_t offsetAlignment() const { return alignment; }
+
+        Fence fence()
+        {
+            issued++;
+            completed = issued > latency && issued - latency > completed ? issued - latency : completed;
+            return issued;
+        }
+
+        bool signaled(Fence fence) const { return fence <= completed; }
+
+        void wait(Fence fence)
+        {
+            waits++;
+            completed = fence > completed ? fence : completed;
+        }
+
+        void release(Fence)
+        {
+            released++;
+        }
+
+        /// Finishes every fence up to fence, as if the GPU caught up
+        void complete(Fence fence) { completed = fence > completed ? fence : completed; }
+
+        Fence issued = 0;
+        Fence completed = 0;
+        std::size_t waits = 0;
+        std::size_t released = 0;
+
+    private:
+
+        struct alignas(16) Chunk
+        {
+            unsigned char bytes[16];
+        };
+
+        std::vector<Chunk> buffer;
+        std::size_t bytes;
+        std::size_t alignment;
+        std::size_t latency;
+    };
+
+    /// A persistently and coherently mapped uniform buffer with sync object fences. Needs GL 4.4 or ARB_buffer_storage
+    class GLRingBackend
+    {
+    public:
+
+        typedef GLsync Fence;
+
+        explicit GLRingBackend(std::size_t size) : bytes(size)
+        {
+            GLint offsetAlignment = 256;
+            glGetIntegerv(GL_UNIFORM_BUFFER_OFFSET_ALIGNMENT, &offsetAlignment);
+            alignment = std::size_t(offsetAlignment);
+
+            const GLbitfield flags = GL_MAP_WRITE_BIT | GL_MAP_PERSISTENT_BIT | GL_MAP_COHERENT_BIT;
+
+            glGenBuffers(1, &name);
+            glBindBuffer(GL_UNIFORM_BUFFER, name);
+            glBufferStorage(GL_UNIFORM_BUFFER, GLsizeiptr(size), nullptr, flags);
+            mapped = static_cast<unsigned char*>(glMapBufferRange(GL_UNIFORM_BUFFER, 0, GLsizeiptr(size), flags));
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+        }
+
+        GLRingBackend(const GLRingBackend&) = delete;
+        GLRingBackend& operator=(const GLRingBackend&) = delete;
+
+        ~GLRingBackend()
+        {
+            glBindBuffer(GL_UNIFORM_BUFFER, name);
+            glUnmapBuffer(GL_UNIFORM_BUFFER);
+            glBindBuffer(GL_UNIFORM_BUFFER, 0);
+            glDeleteBuffers(1, &name);
+        }
+
+        /// The buffer object, for glBindBufferRange
+        GLuint buffer() const { return name; }
+
+        /// Null if the buffer couldn't be mapped
+        unsigned char* memory() { return mapped; }
+        std::size_t size() const { return bytes; }
+        std::size_t offsetAlignment() const { return alignment; }
+
+        Fence fence() { return glFenceSync(GL_SYNC_GPU_COMMANDS_COMPLETE, 0); }
+
+        bool signaled(Fence fence)
+        {
+            const GLenum status = glClientWaitSync(fence, 0, 0);
+            return status == GL_ALREADY_SIGNALED || status == GL_CONDITION_SATISFIED;
+        }
+
+        void wait(Fence fence)
+        {
+            // the first wait flushes, so the fence is sure to reach the GPU
+            GLbitfield flags = GL_SYNC_FLUSH_COMMANDS_BIT;
+
+            while (glClientWaitSync(fence, flags, 1000000) == GL_TIMEOUT_EXPIRED)
+            {
+                flags = 0;
+            }
+        }
+
+        void release(Fence fence) { glDeleteSync(fence); }
+
+    private:
+
+        GLuint name = 0;
+        unsigned char* mapped = nullptr;
+        std::size_t bytes;
+        std::size_t alignment = 256;
+    };
+}
@@ -0,0 +1,351 @@
+#pragma once
+#include "UBOMembers.h"
+#include <string>
+#include <vector>
+
+/// Intro and Usage
+/// For GL paths without uniform buffers (GLES 2 class hardware, or drivers where UBOs are slow), a std140 block can still be uploaded in one call
+/// by declaring it in the shader as a plain array of vec4s :
+///     uniform vec4 u_lights[51];
+///
+/// Every std140 member already sits inside a 16 byte slot (vec3s and vec4s never straddle one, and arrays, matrices and structs start on one),
+/// so the client side struct IS that array, byte for byte. uploadVec4Array() sends it with a single glUniform4fv, instead of one glUniform* per member.
+///
+/// The shader side needs accessors to pull the members back out of the slots, and vec4ArrayGlsl<T>() generates them from the UBO_MEMBERS list :
+///     a struct declaration and a load function for every struct type in the block
+///     a getter per block member, u_lights_nPointLights() or u_lights_pointLights(int i) for arrays
+///
+/// ints, uints and bools are converted to float values when packed (a bool is 0.0 or 1.0) and converted back with int(), uint() and != 0.0,
+/// rather than sent as bit patterns, which would need floatBitsToInt and which drivers that flush denormals would zero for small integers.
+/// A float holds integers exactly up to 2^24, so declare the array highp in GLSL ES. Blocks holding integers go through packVec4(),
+/// all float blocks whose size is a multiple of 16 are uploaded straight from the struct.
+/// Doubles have no place in a vec4 and aren't supported.
+///
+/// The generated GLSL needs GLSL 1.10 or GLSL ES 1.00. uint members need GLSL 1.30 or GLSL ES 3.00, and row_major matrices are read back
+/// with transpose(), which needs GLSL 1.20 or GLSL ES 3.00 (as do non square matrices in GLSL ES).
+///
+/// Here's an example use case:
+
+/**
+struct PointLight : public std140::UBOStruct<>
+{
+    std140::vec3 location;
+    std140::vec3 color;
+
+    UBO_MEMBERS(PointLight, location, color)
+};
+
+struct PointLightUBO
+{
+    std140::int32_t nPointLights = 0;
+    std140::Array<PointLight, 25> pointLights;
+
+    UBO_MEMBERS(PointLightUBO, nPointLights, pointLights)
+};
+
+// shader
+std::string source = "#version 100\nprecision highp float;\n" + std140::vec4ArrayGlsl<PointLightUBO>("u_lights") + lightingCode;
+
+// per frame
+std140::uploadVec4Array(glGetUniformLocation(program, "u_lights"), lights);
+**/
+
+namespace std140
+{
+    static constexpr std::size_t Vec4SlotSize = 16u;
+
+    /// Number of vec4 slots T takes
+    template <typename T>
+    constexpr std::size_t vec4Count()
+    {
+        return (sizeof(T) + Vec4SlotSize - 1) / Vec4SlotSize;
+    }
+
+    /// T as a vec4 array, for blocks whose size isn't already a multiple of 16 or that hold integers
+    template <typename T>
+    using Vec4Image = Array<vec4, int(vec4Count<T>())>;
+
+    namespace detail
+    {
+        /// True if T has int, uint or bool members anywhere, which packVec4 has to convert to floats
+        template <typename T>
+        constexpr bool holdsIntegers()
+        {
+            typedef typename UnwrapArrayElement<T>::type U;
+
+            if constexpr (IsLeaf<U>::value)
+            {
+                return !std::is_same<typename ComponentType<U>::type, GLfloat>::value;
+            }
+            else if constexpr (IsArray<U>::value)
+            {
+                return holdsIntegers<typename ArrayTraits<U>::AlignedType>();
+            }
+            else
+            {
+                bool integers = false;
+                forEachMember<U>([&integers](auto member) { integers = integers || holdsIntegers<typename decltype(member)::type>(); });
+                return integers;
+            }
+        }
+
+        /// Overwrites the int, uint and bool components of the T at offset in image with their float values read from block
+        template <typename T>
+        void convertIntegers(const unsigned char* block, unsigned char* image, std::size_t offset)
+        {
+            typedef typename UnwrapArrayElement<T>::type U;
+
+            if constexpr (!holdsIntegers<U>())
+            {
+            }
+            else if constexpr (IsLeaf<U>::value)
+            {
+                typedef typename ComponentType<U>::type P;
+
+                for (std::size_t i = 0; i < ValueSize<U>::value / sizeof(P); i++)
+                {
+                    P component;
+                    std::memcpy(&component, block + offset + i * sizeof(P), sizeof(P));
+
+                    const GLfloat value = GLfloat(component);
+                    std::memcpy(image + offset + i * sizeof(P), &value, sizeof(value));
+                }
+            }
+            else if constexpr (IsArray<U>::value)
+            {
+                for (std::size_t i = 0; i < ArrayTraits<U>::Length; i++)
+                {
+                    convertIntegers<typename ArrayTraits<U>::AlignedType>(block, image, offset + i * ArrayTraits<U>::Stride);
+                }
+            }
+            else
+            {
+                forEachMember<U>([&](auto member)
+                {
+                    convertIntegers<typename decltype(member)::type>(block, image, offset + member.offset);
+                });
+            }
+        }
+    }
+
+    template <typename T>
+    void packVec4(const T& block, Vec4Image<T>& image)
+    {
+        static_assert(sizeof(Vec4Image<T>) == vec4Count<T>() * Vec4SlotSize, "vec4 slots must be contiguous");
+
+        unsigned char* bytes = reinterpret_cast<unsigned char*>(image.data());
+
+        std::memcpy(bytes, &block, sizeof(T));
+        std::memset(bytes + sizeof(T), 0, sizeof(Vec4Image<T>) - sizeof(T));
+
+        detail::convertIntegers<T>(reinterpret_cast<const unsigned char*>(&block), bytes, 0);
+    }
+
+    /// Uploads the whole block to a uniform vec4[vec4Count<T>()] of the current program
+    template <typename T>
+    void uploadVec4Array(GLint location, const T& block)
+    {
+        if constexpr (sizeof(T) % Vec4SlotSize == 0 && !detail::holdsIntegers<T>())
+        {
+            glUniform4fv(location, GLsizei(vec4Count<T>()), reinterpret_cast<const GLfloat*>(&block));
+        }
+        else
+        {
+            Vec4Image<T> image;
+            packVec4(block, image);
+            glUniform4fv(location, GLsizei(vec4Count<T>()), reinterpret_cast<const GLfloat*>(image.data()));
+        }
+    }
+
+    namespace detail
+    {
+        /// GLSL index expression for slot "base + slot"
+        inline std::string slotIndex(const std::string& base, std::size_t slot)
+        {
+            if (base.empty())
+            {
+                return std::to_string(slot);
+            }
+
+            return slot ? base + " + " + std::to_string(slot) : base;
+        }
+
+        template <typename U>
+        std::string readVec4Leaf(const std::string& uniform, const std::string& base, std::size_t offset)
+        {
+            typedef typename ComponentType<U>::type P;
+
+            static_assert(sizeof(P) == 4, "doubles can't be packed into a vec4 array");
+
+            const std::size_t components = ValueSize<U>::value / sizeof(P);
+            const std::string value = uniform + "[" + slotIndex(base, offset / Vec4SlotSize) + "]." + std::string("xyzw").substr((offset % Vec4SlotSize) / sizeof(P), components);
+
+            // packVec4 stored integers and bools as float values
+            if constexpr (std::is_same<P, GLfloat>::value)
+            {
+                return value;
+            }
+            else if constexpr (!std::is_same<P, Bool32>::value)
+            {
+                return std::string(glslTypeName<U>()) + "(" + value + ")";
+            }
+            else if (components == 1)
+            {
+                return "(" + value + " != 0.0)";
+            }
+            else
+            {
+                return "notEqual(" + value + ", vec" + std::to_string(components) + "(0.0))";
+            }
+        }
+
+        /// GLSL expression reading a non array value of type T at byte offset from slot base
+        template <typename T>
+        std::string readVec4Value(const std::string& uniform, const std::string& base, std::size_t offset)
+        {
+            typedef typename UnwrapArrayElement<T>::type U;
+
+            if constexpr (MatrixTraits<U>::IsMatrix)
+            {
+                typedef MatrixTraits<U> M;
+                typedef typename ArrayTraits<U>::AlignedType Column;
+
+                std::string expression = M::ColumnMajor ? std::string(glslTypeName<U>()) + "(" : "transpose(mat" + std::to_string(M::Rows) + "x" + std::to_string(M::Columns) + "(";
+
+                for (std::size_t i = 0; i < ArrayTraits<U>::Length; i++)
+                {
+                    expression += (i ? ", " : "") + readVec4Leaf<typename UnwrapArrayElement<Column>::type>(uniform, base, offset + i * ArrayTraits<U>::Stride);
+                }
+
+                return expression + (M::ColumnMajor ? ")" : "))");
+            }
+            else if constexpr (IsLeaf<U>::value)
+            {
+                return readVec4Leaf<U>(uniform, base, offset);
+            }
+            else
+            {
+                static_assert(!IsArray<U>::value, "arrays of arrays can't be packed into a vec4 array");
+                static_assert(HasMembers<U>::value, "list the members of nested structs with UBO_MEMBERS");
+
+                return uniform + "_load" + U::uboName() + "(" + slotIndex(base, offset / Vec4SlotSize) + ")";
+            }
+        }
+
+        inline std::string glslDeclaration(const char* type, const char* name, std::size_t length)
+        {
+            return std::string(type) + " " + name + (length ? "[" + std::to_string(length) + "]" : std::string()) + ";\n";
+        }
+
+        /// Length of an array member, 0 if it isn't one
+        template <typename T>
+        constexpr std::size_t arrayLength()
+        {
+            if constexpr (IsArray<T>::value && !MatrixTraits<T>::IsMatrix)
+            {
+                return ArrayTraits<T>::Length;
+            }
+            else
+            {
+                return 0;
+            }
+        }
+
+        /// Appends a declaration and loader for every struct type reachable from T, dependencies first
+        template <typename T>
+        void appendVec4Loaders(const std::string& uniform, bool declareStructs, std::vector<std::string>& done, std::string& glsl)
+        {
+            typedef typename UnwrapArrayElement<T>::type U;
+
+            if constexpr (IsLeaf<U>::value || MatrixTraits<U>::IsMatrix)
+            {
+            }
+            else if constexpr (IsArray<U>::value)
+            {
+                appendVec4Loaders<typename ArrayTraits<U>::AlignedType>(uniform, declareStructs, done, glsl);
+            }
+            else
+            {
+                for (const std::string& name : done)
+                {
+                    if (name == U::uboName())
+                    {
+                        return;
+                    }
+                }
+
+                forEachMember<U>([&](auto member)
+                {
+                    appendVec4Loaders<typename decltype(member)::type>(uniform, declareStructs, done, glsl);
+                });
+
+                done.push_back(U::uboName());
+
+                if (declareStructs)
+                {
+                    glsl += std::string("struct ") + U::uboName() + "\n{\n";
+
+                    forEachMember<U>([&](auto member)
+                    {
+                        typedef typename decltype(member)::type M;
+                        glsl += "    " + glslDeclaration(glslTypeName<M>(), member.name, arrayLength<M>());
+                    });
+
+                    glsl += "};\n\n";
+                }
+
+                glsl += std::string(U::uboName()) + " " + uniform + "_load" + U::uboName() + "(int slot)\n{\n    " + U::uboName() + " value;\n";
+
+                forEachMember<U>([&](auto member)
+                {
+                    typedef typename decltype(member)::type M;
+
+                    if constexpr (arrayLength<M>() != 0)
+                    {
+                        glsl += "    for (int i = 0; i < " + std::to_string(arrayLength<M>()) + "; i++) value." + member.name + "[i] = "
+                            + readVec4Value<typename ArrayTraits<M>::AlignedType>(uniform, "slot + i * " + std::to_string(ArrayTraits<M>::Stride / Vec4SlotSize), member.offset) + ";\n";
+                    }
+                    else
+                    {
+                        glsl += std::string("    value.") + member.name + " = " + readVec4Value<M>(uniform, "slot", member.offset) + ";\n";
+                    }
+                });
+
+                glsl += "    return value;\n}\n\n";
+            }
+        }
+    }
+
+    /// GLSL declaring uniform vec4 <uniform>[vec4Count<T>()] and the accessors for the members of T.
+    /// Pass declareStructs = false if the shader already declares the struct types.
+    template <typename T>
+    std::string vec4ArrayGlsl(const std::string& uniform, bool declareStructs = true)
+    {
+        std::string glsl = "uniform vec4 " + uniform + "[" + std::to_string(vec4Count<T>()) + "];\n\n";
+        std::vector<std::string> done;
+
+        forEachMember<T>([&](auto member)
+        {
+            detail::appendVec4Loaders<typename decltype(member)::type>(uniform, declareStructs, done, glsl);
+        });
+
+        forEachMember<T>([&](auto member)
+        {
+            typedef typename decltype(member)::type M;
+
+            const std::string getter = std::string(glslTypeName<M>()) + " " + uniform + "_" + member.name;
+
+            if constexpr (detail::arrayLength<M>() != 0)
+            {
+                glsl += getter + "(int i) { return "
+                    + detail::readVec4Value<typename ArrayTraits<M>::AlignedType>(uniform, "i * " + std::to_string(ArrayTraits<M>::Stride / Vec4SlotSize), member.offset) + "; }\n";
+            }
+            else
+            {
+                glsl += getter + "() { return " + detail::readVec4Value<M>(uniform, "", member.offset) + "; }\n";
+            }
+        });
+
+        return glsl;
+    }
+}
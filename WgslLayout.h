@@ -0,0 +1,138 @@
+#pragma once
+#include "Std430.h"
+
+/// Intro and Usage
+/// This header defines types you can use to declare WebGPU (WGSL) buffers in the client code
+/// It mirrors the vocabulary of Std140.h, in two namespaces for the two host shareable address spaces
+///     wgsl_uniform  for var<uniform>
+///     wgsl_storage  for var<storage>
+///
+/// The WGSL rules :
+///     i32, u32 and f32 are 4 bytes aligned to 4
+///     vec2 is 8 bytes aligned to 8, vec3 is 12 bytes aligned to 16, vec4 is 16 bytes aligned to 16 (the same as GLSL)
+///     matCxR is C column vectors, each column padded out to its alignment, so mat2x2 is 16 bytes and mat3x3 is 48
+///     array<E, N> is aligned to E, with a stride of sizeof(E) rounded up to the alignment of E
+///     structs are aligned to their largest member, and their size is rounded up to that alignment
+///
+/// which is the std430 layout, so wgsl_storage is std430 without bool and double.
+///
+/// The uniform address space adds these constraints :
+///     arrays and struct members start at a multiple of 16
+///     the array element stride must be a multiple of 16
+/// WGSL does not pad to satisfy them, the shader just fails validation (use array<vec4<f32>, N> instead of array<f32, N>)
+/// so wgsl_uniform::Array fails to compile for any element, scalar, vector or struct, whose stride isn't a multiple of 16,
+/// rather than silently padding like std140::Array does. Structs keep their natural alignment and size, as in WGSL.
+/// wgsl_uniform::Array is aligned to 16, so it starts where WGSL requires. A struct member of a struct type that isn't
+/// 16 aligned has to be placed by hand, with alignas(16) here and @align(16) in the shader.
+///
+/// Here's an example use case:
+
+/**
+struct Light : public wgsl_uniform::UBOStruct<>
+{
+    wgsl_uniform::vec3 direction;         // offset 0
+    wgsl_uniform::float32_t intensity;    // offset 12
+    wgsl_uniform::mat2 rotation;          // offset 16, 16 bytes (32 in std140)
+};
+
+struct Lights
+{
+    wgsl_uniform::Array<Light, 8> lights; // stride 32
+};
+**/
+
+namespace wgsl_storage
+{
+    // https://www.w3.org/TR/WGSL/#alignment-and-size
+
+    using std430::float32_t;
+    using std430::int32_t;
+    using std430::uint32_t;
+
+    using std430::Vector;
+
+    using std430::vec2;
+    using std430::vec3;
+    using std430::vec4;
+
+    using std430::ivec2;
+    using std430::ivec3;
+    using std430::ivec4;
+
+    using std430::uvec2;
+    using std430::uvec3;
+    using std430::uvec4;
+
+    using std430::ArrayAlignment;
+    using std430::Array;
+    using std430::Matrix;
+
+    using std430::mat2;
+    using std430::mat3;
+    using std430::mat4;
+
+    using std430::mat2x3;
+    using std430::mat2x4;
+
+    using std430::mat3x2;
+    using std430::mat3x4;
+
+    using std430::mat4x2;
+    using std430::mat4x3;
+
+    using std430::UBOStruct;
+
+    /// storage buffers can end in a runtime sized array<E>
+    using std430::NoHeader;
+    using std430::RuntimeArray;
+}
+
+namespace wgsl_uniform
+{
+    using std430::float32_t;
+    using std430::int32_t;
+    using std430::uint32_t;
+
+    using std430::Vector;
+
+    using std430::vec2;
+    using std430::vec3;
+    using std430::vec4;
+
+    using std430::ivec2;
+    using std430::ivec3;
+    using std430::ivec4;
+
+    using std430::uvec2;
+    using std430::uvec3;
+    using std430::uvec4;
+
+    // matrices have no extra constraints in the uniform address space, a mat2x2 is still aligned to 8
+    using std430::Matrix;
+
+    using std430::mat2;
+    using std430::mat3;
+    using std430::mat4;
+
+    using std430::mat2x3;
+    using std430::mat2x4;
+
+    using std430::mat3x2;
+    using std430::mat3x4;
+
+    using std430::mat4x2;
+    using std430::mat4x3;
+
+    template <typename T>
+    struct ArrayAlignment : public std430::ArrayAlignment<T>
+    {
+        static_assert(sizeof(typename std430::ArrayAlignment<T>::ArrayAlignedType) % 16 == 0,
+            "the array element stride in the uniform address space must be a multiple of 16, eg. use vec4 instead of float");
+    };
+
+    template <typename P, int SZ>
+    struct ALIGN(16) Array : public std::array<typename ArrayAlignment<P>::ArrayAlignedType, SZ> {};
+
+    /// Structs are aligned to their largest member, as in storage. Arrays of them are checked by ArrayAlignment above
+    using std430::UBOStruct;
+}
@@ -0,0 +1,340 @@
+// Batched uniform block reflection for linked programs, with an on disk cache
+//
+// defines:
+// VIRTUOSO_PROGRAMREFLECTION_IMPLEMENTATION for implementation
+//
+// ReflectProgram() reads every active uniform and uniform block of a program in one pass : one glGetActiveUniformsiv call per
+// property for all the uniforms at once, rather than a glGetUniformIndices / glGetActiveUniformsiv round trip per name.
+// ReflectProgramCached() also stores the result under the hash of the program's sources (see ShaderHash()) and the driver,
+// so a warm start reads a small file and makes no introspection calls at all.
+//
+// The GL entry points come from a ReflectionGL table, ReflectionGL::Current() for the loaded context, or a mock one in tests.
+//
+//    const std::size_t key = Virtuoso::GL::ProgramSourceHash({ vertSource, fragSource });
+//    const Virtuoso::GL::ProgramLayout layout = Virtuoso::GL::ReflectProgramCached(program.name(), key, "shadercache");
+//
+//    const std::size_t light = layout.FindUniform("pointLights[1].location");
+//    if (light != Virtuoso::GL::ProgramLayout::npos) offset = layout.uniforms[light].offset;
+
+#ifndef _GL_PROGRAM_REFLECTION_H_INCLUDED
+#define _GL_PROGRAM_REFLECTION_H_INCLUDED
+
+#include <initializer_list>
+#include <string>
+#include <vector>
+
+namespace Virtuoso
+{
+    namespace GL
+    {
+        /// The entry points reflection calls, so tests can count and fake them
+        struct ReflectionGL
+        {
+            PFNGLGETPROGRAMIVPROC GetProgramiv;
+            PFNGLGETACTIVEUNIFORMSIVPROC GetActiveUniformsiv;
+            PFNGLGETACTIVEUNIFORMNAMEPROC GetActiveUniformName;
+            PFNGLGETACTIVEUNIFORMBLOCKIVPROC GetActiveUniformBlockiv;
+            PFNGLGETACTIVEUNIFORMBLOCKNAMEPROC GetActiveUniformBlockName;
+            PFNGLGETSTRINGPROC GetString;
+
+            /// The functions glad loaded for the current context
+            static ReflectionGL Current();
+        };
+
+        struct ReflectedUniform
+        {
+            std::string name;
+            GLint blockIndex;       // -1 for uniforms outside a block
+            GLint offset;
+            GLint type;
+            GLint arraySize;
+            GLint arrayStride;
+            GLint matrixStride;
+            GLint rowMajor;
+        };
+
+        struct ReflectedBlock
+        {
+            std::string name;
+            GLint dataSize;
+            GLint binding;
+            std::vector<std::size_t> uniforms;  // indices into ProgramLayout::uniforms
+        };
+
+        struct ProgramLayout
+        {
+            static constexpr std::size_t npos = std::size_t(-1);
+
+            std::vector<ReflectedBlock> blocks;         // in block index order
+            std::vector<ReflectedUniform> uniforms;     // in uniform index order
+
+            std::size_t FindUniform(const std::string& name) const;
+            std::size_t FindBlock(const std::string& name) const;
+        };
+
+        /// Combines the ShaderHash() of each source, in order
+        std::size_t ProgramSourceHash(std::initializer_list<std::string> sources);
+
+        /// Every active uniform and uniform block of a linked program, in one batched pass
+        ProgramLayout ReflectProgram(GLuint program, const ReflectionGL& gl = ReflectionGL::Current());
+
+        /// ReflectProgram(), through the cache file <cacheDirectory>/<sourceHash>.layout. The directory must exist.
+        /// A file written by another driver, or another version of this format, is ignored and replaced
+        ProgramLayout ReflectProgramCached(GLuint program, std::size_t sourceHash, const std::string& cacheDirectory, const ReflectionGL& gl = ReflectionGL::Current());
+
+        bool SaveProgramLayout(const std::string& path, const std::string& driver, const ProgramLayout& layout);
+        bool LoadProgramLayout(const std::string& path, const std::string& driver, ProgramLayout& layout);
+    }
+}
+#endif
+
+#ifdef VIRTUOSO_PROGRAMREFLECTION_IMPLEMENTATION
+
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+
+namespace Virtuoso
+{
+    namespace GL
+    {
+        namespace
+        {
+            const char* const LayoutFileMagic = "virtuoso-program-layout 1";
+
+            std::string DriverString(const ReflectionGL& gl)
+            {
+                const GLubyte* renderer = gl.GetString(GL_RENDERER);
+                const GLubyte* version = gl.GetString(GL_VERSION);
+
+                return std::string(renderer ? reinterpret_cast<const char*>(renderer) : "") + " / " + (version ? reinterpret_cast<const char*>(version) : "");
+            }
+        }
+
+        ReflectionGL ReflectionGL::Current()
+        {
+            return ReflectionGL{ glGetProgramiv, glGetActiveUniformsiv, glGetActiveUniformName, glGetActiveUniformBlockiv, glGetActiveUniformBlockName, glGetString };
+        }
+
+        std::size_t ProgramLayout::FindUniform(const std::string& name) const
+        {
+            for (std::size_t i = 0; i < uniforms.size(); i++)
+            {
+                if (uniforms[i].name == name)
+                {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        std::size_t ProgramLayout::FindBlock(const std::string& name) const
+        {
+            for (std::size_t i = 0; i < blocks.size(); i++)
+            {
+                if (blocks[i].name == name)
+                {
+                    return i;
+                }
+            }
+            return npos;
+        }
+
+        std::size_t ProgramSourceHash(std::initializer_list<std::string> sources)
+        {
+            std::size_t hash = 0;
+
+            for (const std::string& src : sources)
+            {
+                hash ^= ShaderHash(src) + 0x9e3779b9u + (hash << 6) + (hash >> 2);
+            }
+
+            return hash;
+        }
+
+        ProgramLayout ReflectProgram(GLuint program, const ReflectionGL& gl)
+        {
+            ProgramLayout layout;
+
+            GLint uniformCount = 0;
+            GLint maxUniformName = 0;
+            GLint blockCount = 0;
+            GLint maxBlockName = 0;
+
+            gl.GetProgramiv(program, GL_ACTIVE_UNIFORMS, &uniformCount);
+            gl.GetProgramiv(program, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxUniformName);
+            gl.GetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCKS, &blockCount);
+            gl.GetProgramiv(program, GL_ACTIVE_UNIFORM_BLOCK_MAX_NAME_LENGTH, &maxBlockName);
+
+            std::vector<GLchar> name(std::size_t(std::max(maxUniformName, maxBlockName)) + 1);
+
+            if (uniformCount > 0)
+            {
+                std::vector<GLuint> indices(uniformCount);
+                for (GLint i = 0; i < uniformCount; i++)
+                {
+                    indices[i] = GLuint(i);
+                }
+
+                const GLenum properties[] = { GL_UNIFORM_BLOCK_INDEX, GL_UNIFORM_OFFSET, GL_UNIFORM_TYPE, GL_UNIFORM_SIZE, GL_UNIFORM_ARRAY_STRIDE, GL_UNIFORM_MATRIX_STRIDE, GL_UNIFORM_IS_ROW_MAJOR };
+                const std::size_t propertyCount = sizeof(properties) / sizeof(properties[0]);
+
+                // one call per property, for every uniform at once
+                std::vector<GLint> values(propertyCount * uniformCount);
+                for (std::size_t p = 0; p < propertyCount; p++)
+                {
+                    gl.GetActiveUniformsiv(program, uniformCount, indices.data(), properties[p], values.data() + p * uniformCount);
+                }
+
+                layout.uniforms.resize(uniformCount);
+
+                for (GLint i = 0; i < uniformCount; i++)
+                {
+                    GLsizei length = 0;
+                    gl.GetActiveUniformName(program, GLuint(i), GLsizei(name.size()), &length, name.data());
+
+                    ReflectedUniform& uniform = layout.uniforms[i];
+                    uniform.name.assign(name.data(), length);
+                    uniform.blockIndex = values[0 * uniformCount + i];
+                    uniform.offset = values[1 * uniformCount + i];
+                    uniform.type = values[2 * uniformCount + i];
+                    uniform.arraySize = values[3 * uniformCount + i];
+                    uniform.arrayStride = values[4 * uniformCount + i];
+                    uniform.matrixStride = values[5 * uniformCount + i];
+                    uniform.rowMajor = values[6 * uniformCount + i];
+                }
+            }
+
+            layout.blocks.resize(std::max(blockCount, 0));
+
+            for (GLint b = 0; b < blockCount; b++)
+            {
+                GLsizei length = 0;
+                gl.GetActiveUniformBlockName(program, GLuint(b), GLsizei(name.size()), &length, name.data());
+
+                ReflectedBlock& block = layout.blocks[b];
+                block.name.assign(name.data(), length);
+                block.dataSize = 0;
+                block.binding = 0;
+
+                gl.GetActiveUniformBlockiv(program, GLuint(b), GL_UNIFORM_BLOCK_DATA_SIZE, &block.dataSize);
+                gl.GetActiveUniformBlockiv(program, GLuint(b), GL_UNIFORM_BLOCK_BINDING, &block.binding);
+            }
+
+            // block membership comes from the uniforms, saving a GL_UNIFORM_BLOCK_ACTIVE_UNIFORM_INDICES query per block
+            for (std::size_t i = 0; i < layout.uniforms.size(); i++)
+            {
+                const GLint b = layout.uniforms[i].blockIndex;
+                if (b >= 0 && b < blockCount)
+                {
+                    layout.blocks[b].uniforms.push_back(i);
+                }
+            }
+
+            return layout;
+        }
+
+        bool SaveProgramLayout(const std::string& path, const std::string& driver, const ProgramLayout& layout)
+        {
+            // written to the side and renamed, so a crash mid write can't leave a truncated layout behind
+            const std::string temporary = path + ".tmp";
+
+            {
+                std::ofstream file(temporary, std::ios::binary);
+
+                file << LayoutFileMagic << "\n" << driver << "\n";
+                file << layout.blocks.size() << " " << layout.uniforms.size() << "\n";
+
+                for (const ReflectedBlock& block : layout.blocks)
+                {
+                    file << block.name << " " << block.dataSize << " " << block.binding << "\n";
+                }
+
+                for (const ReflectedUniform& uniform : layout.uniforms)
+                {
+                    file << uniform.name << " " << uniform.blockIndex << " " << uniform.offset << " " << uniform.type << " " << uniform.arraySize << " "
+                        << uniform.arrayStride << " " << uniform.matrixStride << " " << uniform.rowMajor << "\n";
+                }
+
+                if (!file)
+                {
+                    return false;
+                }
+            }
+
+            std::remove(path.c_str());
+            return std::rename(temporary.c_str(), path.c_str()) == 0;
+        }
+
+        bool LoadProgramLayout(const std::string& path, const std::string& driver, ProgramLayout& layout)
+        {
+            std::ifstream file(path, std::ios::binary);
+            if (!file)
+            {
+                return false;
+            }
+
+            std::string magic;
+            std::string fileDriver;
+
+            if (!std::getline(file, magic) || magic != LayoutFileMagic || !std::getline(file, fileDriver) || fileDriver != driver)
+            {
+                return false;
+            }
+
+            std::size_t blockCount = 0;
+            std::size_t uniformCount = 0;
+            file >> blockCount >> uniformCount;
+
+            ProgramLayout loaded;
+            loaded.blocks.resize(blockCount);
+            loaded.uniforms.resize(uniformCount);
+
+            for (ReflectedBlock& block : loaded.blocks)
+            {
+                file >> block.name >> block.dataSize >> block.binding;
+            }
+
+            for (std::size_t i = 0; i < uniformCount; i++)
+            {
+                ReflectedUniform& uniform = loaded.uniforms[i];
+                file >> uniform.name >> uniform.blockIndex >> uniform.offset >> uniform.type >> uniform.arraySize >> uniform.arrayStride >> uniform.matrixStride >> uniform.rowMajor;
+
+                if (uniform.blockIndex >= 0 && std::size_t(uniform.blockIndex) < blockCount)
+                {
+                    loaded.blocks[uniform.blockIndex].uniforms.push_back(i);
+                }
+            }
+
+            if (!file)
+            {
+                return false;
+            }
+
+            layout = std::move(loaded);
+            return true;
+        }
+
+        ProgramLayout ReflectProgramCached(GLuint program, std::size_t sourceHash, const std::string& cacheDirectory, const ReflectionGL& gl)
+        {
+            std::ostringstream path;
+            path << cacheDirectory << "/" << std::hex << sourceHash << ".layout";
+
+            const std::string driver = DriverString(gl);
+
+            ProgramLayout layout;
+            if (LoadProgramLayout(path.str(), driver, layout))
+            {
+                return layout;
+            }
+
+            layout = ReflectProgram(program, gl);
+            SaveProgramLayout(path.str(), driver, layout);
+
+            return layout;
+        }
+    }
+}
+
+#endif
@@ -14,6 +14,9 @@ namespace Virtuoso
 {
     namespace GL
     {
+        /// The hash Shader() logs a source under, also the key ProgramReflection.h caches program layouts by
+        std::size_t ShaderHash(const std::string& src);
+
         gl::Shader Shader(GLenum shaderType, const std::string& src);
         gl::Program Program(std::initializer_list<gl::Shader> shaders);
     }
@@ -29,15 +32,20 @@ namespace Virtuoso
 {
     namespace GL
     {
-        gl::Shader Shader(GLenum shaderType, const std::string& src)
+        std::size_t ShaderHash(const std::string& src)
         {
             static std::hash<std::string> hash_fn;
 
+            return hash_fn(src);
+        }
+
+        gl::Shader Shader(GLenum shaderType, const std::string& src)
+        {
 #ifdef VIRTUOSO_LOG_SHADERS
             std::clog<<"Shader SRC : "<< src << std::endl;
 
 #else
-            std::clog<< "\n\nShader with hash : " << hash_fn(src) << std::endl;
+            std::clog<< "\n\nShader with hash : " << ShaderHash(src) << std::endl;
 #endif
             gl::Shader rval(shaderType);
 
@@ -0,0 +1,333 @@
+/// std140Bench : the uploads RangeCoalescer.h makes for the PBR demo blocks of test/main.cpp, at a range of gaps
+///
+///     std140Bench [frames]
+///
+/// Each scenario writes a few members of a block per frame through a Tracked<>, and coalesces the dirty ranges at every gap.
+/// For each gap it prints the calls and bytes per frame, their cost under the model, and the time coalescing took.
+/// "break even" is the gap the cost model picks on its own, "whole" joins everything into one upload.
+///
+/// Then it times ShadowDiff.h diffing a scene's worth of sphere blocks against their shadows, with a few members changed each frame,
+/// and UniformRing.h pushing light blocks through rings of a few sizes on the mock backend, counting the stalls of each.
+/// Last, a writer and a reader thread hand light blocks over through a TripleBuffer.h and through a block behind a mutex, as fast as they can.
+
+// the headers only need the GL typedefs, nothing is called
+#include <glad/glad.h>
+
+#include "../RangeCoalescer.h"
+#include "../ShadowDiff.h"
+#include "../Tracked.h"
+#include "../UniformRing.h"
+#include "../TripleBuffer.h"
+#include "pbr_lights.glsl.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <mutex>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace
+{
+    // about a microsecond of driver work per glBufferSubData, and 4 GB/s, in nanoseconds
+    const std140::UploadCost Model{ 1000.0, 0.25 };
+
+    template <typename T>
+    void runScenario(const std::string& title, std::size_t frames, const std::function<void(std140::Tracked<T>&, std::mt19937&)>& frame)
+    {
+        std::cout << title << " : " << sizeof(T) << " bytes\n\n";
+        std::cout << std::setw(18) << "gap" << std::setw(10) << "calls" << std::setw(10) << "bytes" << std::setw(12) << "cost" << std::setw(14) << "ns/coalesce" << "\n";
+
+        const std::size_t gaps[] = { 0, 16, 64, 256, 1024, Model.breakEvenGap(), std::size_t(-1) };
+
+        for (std::size_t gap : gaps)
+        {
+            std140::Tracked<T> block;
+            block.flush();      // the first upload of the whole block isn't part of the per frame cost
+            std140::RangeCoalescer coalescer = std140::RangeCoalescer::forBlock<T>(Model);
+            coalescer.setMaxGap(gap);
+
+            // every gap sees the same frames
+            std::mt19937 random(1234);
+
+            std::size_t calls = 0;
+            std::size_t bytes = 0;
+            std::chrono::nanoseconds elapsed(0);
+
+            for (std::size_t f = 0; f < frames; f++)
+            {
+                frame(block, random);
+
+                const std::vector<std140::MemberRange>& dirty = block.flush();
+
+                const auto start = std::chrono::steady_clock::now();
+                const std140::UploadStats stats = std140::uploadStats(coalescer.coalesce(dirty));
+                elapsed += std::chrono::steady_clock::now() - start;
+
+                calls += stats.calls;
+                bytes += stats.bytes;
+            }
+
+            const std::string name = gap == std::size_t(-1) ? "whole" : gap == Model.breakEvenGap() ? std::to_string(gap) + " (break even)" : std::to_string(gap);
+
+            std::cout << std::setw(18) << name << std::fixed << std::setprecision(1)
+                << std::setw(10) << double(calls) / frames
+                << std::setw(10) << double(bytes) / frames
+                << std::setw(12) << Model.of(calls, bytes) / frames
+                << std::setw(14) << double(elapsed.count()) / frames << "\n";
+        }
+
+        std::cout << "\n";
+    }
+
+    /// Diffs count blocks of T per frame, after changing one float in every changeEvery-th block
+    template <typename T>
+    void runShadowDiff(const std::string& title, std::size_t count, std::size_t changeEvery, std::size_t frames)
+    {
+        std::vector<T> blocks(count);
+        std::vector<std140::Shadow<T> > shadows(count);
+
+        for (std::size_t i = 0; i < count; i++)
+        {
+            shadows[i].diff(blocks[i]);
+        }
+
+        std::mt19937 random(1234);
+        std::size_t ranges = 0;
+        std::chrono::nanoseconds elapsed(0);
+
+        for (std::size_t f = 0; f < frames; f++)
+        {
+            for (std::size_t i = random() % changeEvery; i < count; i += changeEvery)
+            {
+                float* values = reinterpret_cast<float*>(&blocks[i]);
+                values[random() % (sizeof(T) / sizeof(float))] += 1.0f;
+            }
+
+            const auto start = std::chrono::steady_clock::now();
+            for (std::size_t i = 0; i < count; i++)
+            {
+                ranges += shadows[i].diff(blocks[i]).size();
+            }
+            elapsed += std::chrono::steady_clock::now() - start;
+        }
+
+        const double bytes = double(sizeof(T)) * count * frames;
+
+        std::cout << title << " : " << count << " x " << sizeof(T) << " bytes, " << std::fixed << std::setprecision(1)
+            << double(ranges) / frames << " ranges per frame, " << double(elapsed.count()) / frames / 1000.0 << " us per frame, "
+            << bytes / double(elapsed.count()) << " GB/s\n";
+    }
+
+    /// Pushes blocksPerFrame light blocks a frame through a ring of ringSize bytes, on a GPU latency frames behind
+    void runUniformRing(std::size_t ringSize, std::size_t latency, std::size_t blocksPerFrame, std::size_t frames)
+    {
+        std140::UniformRing<std140::MockRingBackend> ring(ringSize, 256, latency);
+        const pbr_lights::PointLightBlock lights{};
+
+        const auto start = std::chrono::steady_clock::now();
+        for (std::size_t f = 0; f < frames; f++)
+        {
+            for (std::size_t i = 0; i < blocksPerFrame; i++)
+            {
+                ring.push(lights);
+            }
+            ring.endFrame();
+        }
+        const std::chrono::nanoseconds elapsed = std::chrono::steady_clock::now() - start;
+
+        const std140::UniformRingStats& stats = ring.stats();
+
+        std::cout << std::setw(10) << ringSize / 1024 << std::setw(10) << latency << std::setw(12) << blocksPerFrame
+            << std::setw(12) << double(stats.stalls) / frames << std::setw(10) << stats.failed << std::setw(12) << double(stats.paddingBytes) / frames
+            << std::setw(14) << double(elapsed.count()) / stats.allocations << "\n";
+    }
+
+    /// A block guarded by a mutex, the handoff TripleBuffer replaces
+    template <typename T>
+    class LockedBlock
+    {
+    public:
+
+        void publish(const T& block)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            value = block;
+            version++;
+        }
+
+        bool acquire(T& block, std::size_t& seen)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (version == seen)
+            {
+                return false;
+            }
+
+            block = value;
+            seen = version;
+            return true;
+        }
+
+    private:
+
+        std::mutex mutex;
+        T value{};
+        std::size_t version = 0;
+    };
+
+    /// A writer thread publishing frames and this one acquiring them, for the given time
+    /// acquire() returns whether it got a new frame, and counts the frames it finds half written in torn
+    template <typename Publish, typename Acquire>
+    void runHandoff(const std::string& title, std::chrono::milliseconds duration, const std::size_t& torn, Publish publish, Acquire acquire)
+    {
+        std::atomic<bool> running{ true };
+        std::size_t published = 0;
+
+        std::thread writer([&]()
+        {
+            for (std140::int32_t frame = 1; running.load(std::memory_order_relaxed); frame++)
+            {
+                publish(frame);
+                published++;
+            }
+        });
+
+        std::size_t attempts = 0;
+        std::size_t acquired = 0;
+
+        const auto end = std::chrono::steady_clock::now() + duration;
+        while (std::chrono::steady_clock::now() < end)
+        {
+            acquired += acquire() ? 1 : 0;
+            attempts++;
+        }
+
+        running = false;
+        writer.join();
+
+        const double seconds = std::chrono::duration<double>(duration).count();
+
+        std::cout << std::setw(14) << title << std::fixed << std::setprecision(0)
+            << std::setw(16) << published / seconds << std::setw(16) << attempts / seconds
+            << std::setw(16) << acquired / seconds << std::setw(10) << torn << "\n";
+    }
+}
+
+int main(int argc, char** argv)
+{
+    const std::size_t frames = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 10000;
+
+    std::cout << "cost model : " << Model.perCall << " per call + " << Model.perByte << " per byte, break even gap " << Model.breakEvenGap() << " bytes\n\n";
+
+    runScenario<pbr_lights::PointLightBlock>("PointLightBlock, one light moves", frames, [](std140::Tracked<pbr_lights::PointLightBlock>& lights, std::mt19937& random)
+    {
+        const std::size_t i = random() % pbr_lights::MAX_POINT_LIGHTS;
+        lights.set(lights->pointLights[i].location, std140::vec3{ { float(i), 1.0f, 0.0f } });
+    });
+
+    runScenario<pbr_lights::PointLightBlock>("PointLightBlock, 5 lights move", frames, [](std140::Tracked<pbr_lights::PointLightBlock>& lights, std::mt19937& random)
+    {
+        for (int n = 0; n < 5; n++)
+        {
+            const std::size_t i = random() % pbr_lights::MAX_POINT_LIGHTS;
+            lights.set(lights->pointLights[i].location, std140::vec3{ { float(i), 1.0f, 0.0f } });
+        }
+    });
+
+    runScenario<pbr_lights::PointLightBlock>("PointLightBlock, every light changes color", frames, [](std140::Tracked<pbr_lights::PointLightBlock>& lights, std::mt19937&)
+    {
+        for (std::size_t i = 0; i < pbr_lights::MAX_POINT_LIGHTS; i++)
+        {
+            lights.set(lights->pointLights[i].color, std140::vec3{ { 1.0f, 0.5f, 0.25f } });
+        }
+    });
+
+    runScenario<pbr_lights::SphereInstances>("SphereInstances, 10% of the roughnesses change", frames, [](std140::Tracked<pbr_lights::SphereInstances>& spheres, std::mt19937& random)
+    {
+        for (std::size_t n = 0; n < pbr_lights::MAX_SPHERES / 10; n++)
+        {
+            const std::size_t i = random() % pbr_lights::MAX_SPHERES;
+            spheres.set(spheres->instanceMaterials[i].roughness, 0.5f);
+        }
+    });
+
+#if defined(STD140_SHADOW_SIMD) && defined(__AVX2__)
+    std::cout << "shadow diff, AVX2\n\n";
+#elif defined(STD140_SHADOW_SIMD)
+    std::cout << "shadow diff, SSE2\n\n";
+#else
+    std::cout << "shadow diff, scalar\n\n";
+#endif
+
+    runShadowDiff<pbr_lights::SphereInstances>("SphereInstances, 1 in 16 blocks changes", 256, 16, frames / 10 + 1);
+    runShadowDiff<pbr_lights::PointLightBlock>("PointLightBlock, every block changes", 1024, 1, frames / 10 + 1);
+
+    std::cout << "\nuniform ring, " << sizeof(pbr_lights::PointLightBlock) << " byte light blocks at 256 byte alignment\n\n";
+    std::cout << std::setw(10) << "ring KB" << std::setw(10) << "latency" << std::setw(12) << "per frame" << std::setw(12) << "stalls" << std::setw(10) << "failed" << std::setw(12) << "padding" << std::setw(14) << "ns/push" << "\n";
+
+    const std::size_t ringSizes[] = { 128 * 1024, 256 * 1024, 512 * 1024, 1024 * 1024 };
+    for (std::size_t ringSize : ringSizes)
+    {
+        runUniformRing(ringSize, 2, 100, frames);
+        runUniformRing(ringSize, 3, 100, frames);
+    }
+
+    std::cout << "\nhandoff of " << sizeof(pbr_lights::PointLightBlock) << " byte light blocks between two threads, per second\n\n";
+    std::cout << std::setw(14) << "" << std::setw(16) << "published" << std::setw(16) << "acquire calls" << std::setw(16) << "frames read" << std::setw(10) << "torn" << "\n";
+
+    const std::chrono::milliseconds duration(500);
+
+    {
+        std140::TripleBuffer<pbr_lights::PointLightBlock> lights;
+        std::size_t torn = 0;
+
+        runHandoff("triple buffer", duration, torn,
+            [&lights](std140::int32_t frame)
+            {
+                lights.write().nPointLights = frame;
+                lights.write().pointLights[0].location[0] = float(frame);
+                lights.publish();
+            },
+            [&lights, &torn]()
+            {
+                if (!lights.acquire())
+                {
+                    return false;
+                }
+                torn += lights.read().pointLights[0].location[0] != float(lights.read().nPointLights) ? 1 : 0;
+                return true;
+            });
+    }
+
+    {
+        LockedBlock<pbr_lights::PointLightBlock> lights;
+        pbr_lights::PointLightBlock writing{};
+        pbr_lights::PointLightBlock reading{};
+        std::size_t seen = 0;
+        std::size_t torn = 0;
+
+        runHandoff("mutex", duration, torn,
+            [&lights, &writing](std140::int32_t frame)
+            {
+                writing.nPointLights = frame;
+                writing.pointLights[0].location[0] = float(frame);
+                lights.publish(writing);
+            },
+            [&lights, &reading, &seen, &torn]()
+            {
+                if (!lights.acquire(reading, seen))
+                {
+                    return false;
+                }
+                torn += reading.pointLights[0].location[0] != float(reading.nPointLights) ? 1 : 0;
+                return true;
+            });
+    }
+
+    return 0;
+}
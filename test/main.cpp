@@ -37,78 +37,70 @@
 #include <cmath>
 
 #include <sstream>
+#include <vector>
+#include <thread>
 
 #define VIRTUOSO_SHADERPROGRAMLIB_IMPLEMENTATION
 #include "ShaderProgramLib.h"
 #undef VIRTUOSO_SHADERPROGRAMLIB_IMPLEMENTATION
 
+#define VIRTUOSO_PROGRAMREFLECTION_IMPLEMENTATION
+#include "ProgramReflection.h"
+#undef VIRTUOSO_PROGRAMREFLECTION_IMPLEMENTATION
+
 #include "../Std140.h"
+#include "../Std430.h"
+#include "../ScalarLayout.h"
+#include "../HlslCBuffer.h"
+#include "../MslLayout.h"
+#include "../WgslLayout.h"
+#include "../Transcode.h"
+#include "../AttributeLayout.h"
+#include "../Vec4Pack.h"
+#include "../UBOReflection.h"
+#include "../GlslBlockParser.h"
+#include "../GlslEmitter.h"
+#include "../LayoutPlanner.h"
+#include "../PaddingReport.h"
+#include "../DynamicLayout.h"
+#include "../LayoutMigration.h"
+#include "../Tracked.h"
+#include "../RangeCoalescer.h"
+#include "../ShadowDiff.h"
+#include "../UniformRing.h"
+#include "../TripleBuffer.h"
 
 
 //#include <GL/glew.h>
 
 bool verbose = false;
 
-struct InstanceMaterial : public std140::UBOStruct<>
-{
-    std140::vec3  surfaceColor = { {1.0f,0.0f,0.0f} };
-    std140::float32_t roughness = 1.f;
-    std140::vec3  emissive = { {0.f, 0.f, 0.f} };
-    std140::float32_t metallic = 0.f;
-};
-
-struct PointLight : public std140::UBOStruct<>
-{
-    std140::vec3 location;
-    std140::vec3 color;
-};
-
-struct DirectionalLight : public std140::UBOStruct<>
-{
-    std140::vec3 direction;
-    std140::vec3 color;
-};
-
-const std::size_t MAX_DIRECTIONAL_LIGHTS = 25u;
-
-struct DirectionalLightUBO
-{
-    std140::int32_t nDirectionalLights = 0;
-    std140::Array<DirectionalLight, MAX_DIRECTIONAL_LIGHTS> directionalLights;
-};
-
-const std::size_t MAX_POINT_LIGHTS = 25u;
+// the light and material structs of the PBR demo, generated by glsl2std140 from test/shaders/pbr_lights.glsl
+#include "pbr_lights.glsl.h"
 
-struct PointLightUBO
-{
-    std140::int32_t nPointLights = 0;
-    std140::Array<PointLight, MAX_POINT_LIGHTS> pointLights;
-};
+using pbr_lights::MAX_DIRECTIONAL_LIGHTS;
+using pbr_lights::MAX_POINT_LIGHTS;
+using pbr_lights::MAX_SPHERES;
 
-const std::size_t MAX_SPHERES = 5;
+typedef pbr_lights::InstanceMaterial<> InstanceMaterial;
+typedef pbr_lights::PointLight<> PointLight;
+typedef pbr_lights::DirectionalLight<> DirectionalLight;
 
-struct SphereUBO
-{
-    std140::Array<InstanceMaterial, MAX_SPHERES> instances;
-};
+typedef pbr_lights::DirectionalLightBlock DirectionalLightUBO;
+typedef pbr_lights::PointLightBlock PointLightUBO;
+typedef pbr_lights::SphereInstances SphereUBO;
 
 // tests the structs pulled from the actual PBR demo application
 void ActualAppTest(GLint program)
 {
-    SphereUBO sphereUBO;
-    PointLightUBO plUBO;
-    DirectionalLightUBO dlUBO;
+    constexpr std::size_t plOff2 = std140::offset_of<PointLightUBO>("pointLights[0].location");
+    constexpr std::size_t plOff3 = std140::offset_of<PointLightUBO>("pointLights[1].location");
 
-    const std::size_t plBaseOff = (std::size_t) &plUBO.nPointLights;
-    const std::size_t plOff2 = (std::size_t) & plUBO.pointLights[0].location - plBaseOff;
-    const std::size_t plOff3 = (std::size_t) & plUBO.pointLights[1].location - plBaseOff;
+    constexpr std::size_t dlOff2 = std140::offset_of<DirectionalLightUBO>("directionalLights[0].direction");
+    constexpr std::size_t dlOff3 = std140::offset_of<DirectionalLightUBO>("directionalLights[1].direction");
 
-    const std::size_t dlBaseOff = (std::size_t) & dlUBO.nDirectionalLights;
-    const std::size_t dlOff2 = (std::size_t) & dlUBO.directionalLights[0].direction - dlBaseOff;
-    const std::size_t dlOff3 = (std::size_t) & dlUBO.directionalLights[1].direction - dlBaseOff;
-
-    const std::size_t sph1 = (std::size_t) & sphereUBO.instances[0].surfaceColor;
-    const std::size_t sph2 = (std::size_t) &sphereUBO.instances[1].surfaceColor - sph1;
+    constexpr std::size_t sph1 = std140::offset_of<SphereUBO>("instanceMaterials[0].surfaceColor");
+    constexpr std::size_t sph2 = std140::offset_of<SphereUBO>("instanceMaterials[1].surfaceColor");
 
     const int testUniformCount = 8;
 
@@ -120,7 +112,7 @@ void ActualAppTest(GLint program)
         offsetof(DirectionalLightUBO, nDirectionalLights),
         dlOff2,
         dlOff3,
-        0,
+        sph1,
         sph2
     };
 
@@ -167,6 +159,8 @@ struct TestMatrixStruct : public std140::UBOStruct<>
     std140::mat2x3 d;
     std140::float32_t e;
 
+    UBO_MEMBERS(TestMatrixStruct, a, b, c, d, e)
+
     static void uboOffsetTest(GLint program)
     {
         const GLint testUniformCount = 5;
@@ -789,82 +783,1620 @@ struct TestStruct6 : public std140::UBOStruct<>
     }
 };
 
+struct TestBoolStruct : public std140::UBOStruct<>
+{
+    std140::bool32_t a;
+    std140::bvec3 b;
+    std140::Array<std140::bool32_t, 2> c;
+    std140::bvec2 d;
 
-#include "testshaders.h"
-//#include <Virtuoso/GL/GLFWApplication.h>
+    UBO_MEMBERS(TestBoolStruct, a, b, c, d)
 
-int main(void)
+    static void uboOffsetTest(GLint program)
+    {
+        TestBoolStruct test{};
+        test.a = true;
+        test.b = { true, false, true };
+
+        const GLint testUniformCount = 5;
+
+        GLuint clientOffsets[testUniformCount]
+        {
+            offsetof(TestBoolStruct, a),
+            offsetof(TestBoolStruct, b),
+            offsetof(TestBoolStruct, c),
+            offsetof(TestBoolStruct, c) + sizeof(std140::ArrayAlignment<std140::bool32_t>::ArrayAlignedType),
+            offsetof(TestBoolStruct, d)
+        };
+
+        const GLchar* names[testUniformCount] =
+        {
+            "boolStruct.a",
+            "boolStruct.b",
+            "boolStruct.c[0]",
+            "boolStruct.c[1]",
+            "boolStruct.d",
+        };
+
+        GLuint rval[testUniformCount] = { 0u };
+        GLint rval2[testUniformCount] = { 0u };
+
+        glGetUniformIndices(program, testUniformCount, names, rval);
+        glGetActiveUniformsiv(program, testUniformCount, rval, GL_UNIFORM_OFFSET, rval2);
+
+        // GLSL reads a bool as a whole 32 bit word, so true has to fill it
+        GLuint words[7] = { 0u };
+        std::memcpy(words, &test, sizeof(words));
+
+        bool passed = words[0] == 1u && words[4] == 1u && words[5] == 0u && words[6] == 1u && test.b[0] && !test.b[1] && test.b[2];
+        for (int i = 0; i < testUniformCount; i++)
+        {
+            passed = (rval2[i] == clientOffsets[i]) && passed;
+        }
+
+        std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
+
+        if (!passed || verbose)
+        {
+            for (int i = 0; i < testUniformCount; i++)
+            {
+                std::cout << names[i] << " :: " << rval[i] << "\n\tGLSL offset : " << rval2[i] << "\n\tClient Offset : " << clientOffsets[i] << std::endl;
+            }
+        }
+    }
+};
+
+static_assert(sizeof(std140::bool32_t) == 4, "bool32_t : GLSL bools are 32 bits");
+static_assert(sizeof(std140::bvec3) == 12 && alignof(std140::bvec3) == 16, "bvec3 : same size and alignment as ivec3");
+static_assert(sizeof(std140::Array<std140::dvec3, 2>) == 64 && alignof(std140::Array<std140::dvec3, 2>) == 32, "dvec3 arrays : 32 byte aligned elements");
+static_assert(sizeof(std140::dmat3) == 96 && alignof(std140::dmat3) == 32 && sizeof(std140::dmat2x3) == 64, "dmat3 : dvec3 columns, 32 byte aligned");
+static_assert(std::is_trivially_copyable<TestBoolStruct>::value, "bool blocks can be copied with memcpy");
+
+constexpr std140::ArrayAlignment<std140::bool32_t>::ArrayAlignedType defaultBoolElement;
+static_assert(!defaultBoolElement && defaultBoolElement.value == 0u, "bool32_t : array elements start out false");
+
+static_assert(std140::reflect<TestMatrixStruct>()[2].offset == offsetof(TestMatrixStruct, c), "reflection : offsets match offsetof");
+static_assert(std140::reflect<TestMatrixStruct>()[3].matrixStride == 16, "reflection : std140 matrix columns are vec4 aligned");
+static_assert(std140::reflect<TestBoolStruct>()[2].arrayLength == 2 && std140::reflect<TestBoolStruct>()[2].arrayStride == 16, "reflection : std140 array stride");
+static_assert(std140::memberIndex<TestBoolStruct>("d") == 3, "reflection : lookup by name");
+static_assert(std140::offset_of<TestMatrixStruct>("c") == offsetof(TestMatrixStruct, c), "offset_of : a direct member");
+static_assert(std140::offset_of<PointLightUBO>("pointLights[1].color") == 64, "offset_of : through an Array<> of structs");
+static_assert(std140::range_of<PointLightUBO>("pointLights[1].color").size == 12, "offset_of : a vec3 covers 12 bytes");
+static_assert(std140::offset_of<TestMatrixStruct>("d[1]") == offsetof(TestMatrixStruct, d) + 16, "offset_of : a Matrix column");
+static_assert(std140::offset_of<PointLightUBO>("pointLights[25]") == std140::MemberRange::npos, "offset_of : indices are bounds checked");
+static_assert(std140::offset_of<TestBoolStruct>("missing") == std140::MemberRange::npos, "offset_of : unknown members don't resolve");
+
+// checks every scalar, vector and matrix member of T's reflection table against the GL uniform queries, for a block member of type T named instanceName
+template <typename T>
+void ReflectionTest(GLint program, const std::string& instanceName)
 {
-    glfw::Window::Hints hnts;
-    glfw::Window wind(640, 480, hnts, "std140 Unit Test");
+    constexpr auto table = std140::reflect<T>();
 
-    wind.MakeContextCurrent();
+    const GLint testUniformCount = GLint(table.size());
 
-    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    std::vector<std::string> nameStrings;
+    std::vector<const GLchar*> names;
+
+    for (const std140::MemberInfo& member : table)
     {
-        std::cout << "Failed to initialize GLAD" << std::endl;
-        return -1;
+        nameStrings.push_back(instanceName + "." + member.name + (member.arrayLength ? "[0]" : ""));
     }
- 
-    const GLubyte* vendorStr = glGetString(GL_RENDERER);
 
-    std::cout << "OpenGL Renderer : " << vendorStr << std::endl;
+    for (const std::string& name : nameStrings)
     {
-        gl::Program bunnyProg(
-            Virtuoso::GL::Program(
-                {
-                    Virtuoso::GL::Shader(GL_VERTEX_SHADER, bunnyVert),
-                    Virtuoso::GL::Shader(GL_FRAGMENT_SHADER, bunnyFrag)
-                }
-        ));
+        names.push_back(name.c_str());
+    }
 
-        std::cout << "sizeof(vec3) : " << sizeof(std140::vec3) << std::endl;
-        std::cout << "Align of vec4 " << alignof(std140::vec4) << std::endl;
-        std::cout << "Size of float[4] in glsl ubo std140 : " << sizeof(std140::Array<std140::ArrayAlignment<GLfloat>::ArrayAlignedType, 4>) << std::endl;
-        std::cout << "Size of vec2[4] in glsl ubo std140 : " << sizeof(std140::Array<std140::ArrayAlignment<std140::vec2>::ArrayAlignedType, 4>) << std::endl;
-        std::cout << "Alignment of array aligned float " << alignof(std140::ArrayAlignment<GLfloat>::ArrayAlignedType) << std::endl;
+    std::vector<GLuint> rval(testUniformCount);
+    std::vector<GLint> offsets(testUniformCount), arrayStrides(testUniformCount), matrixStrides(testUniformCount), rowMajor(testUniformCount);
 
-        int tn = 1;
-        const int totalTests = 11;
-        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
-        TestStruct::uboOffsetTest(bunnyProg.name());
+    glGetUniformIndices(program, testUniformCount, names.data(), rval.data());
+    glGetActiveUniformsiv(program, testUniformCount, rval.data(), GL_UNIFORM_OFFSET, offsets.data());
+    glGetActiveUniformsiv(program, testUniformCount, rval.data(), GL_UNIFORM_ARRAY_STRIDE, arrayStrides.data());
+    glGetActiveUniformsiv(program, testUniformCount, rval.data(), GL_UNIFORM_MATRIX_STRIDE, matrixStrides.data());
+    glGetActiveUniformsiv(program, testUniformCount, rval.data(), GL_UNIFORM_IS_ROW_MAJOR, rowMajor.data());
 
-        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
-        TestStruct2::uboOffsetTest(bunnyProg.name());
+    bool passed = true;
+    for (int i = 0; i < testUniformCount; i++)
+    {
+        const std140::MemberInfo& member = table[i];
 
-        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
-        TestStruct3::uboOffsetTest(bunnyProg.name());
+        if (member.kind != std140::MemberKind::Struct)
+        {
+            passed = (offsets[i] == GLint(member.offset)) && (arrayStrides[i] == GLint(member.arrayStride)) &&
+                (matrixStrides[i] == GLint(member.matrixStride)) && ((rowMajor[i] != 0) == member.rowMajor) && passed;
+        }
+    }
 
-        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
-        TestStruct3::uboOffsetTest2(bunnyProg.name());
+    std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
 
-        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
-        TestStruct4::uboOffsetTest(bunnyProg.name());
+    if (!passed || verbose)
+    {
+        for (int i = 0; i < testUniformCount; i++)
+        {
+            const std140::MemberInfo& member = table[i];
 
-        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
-        TestStruct5::uboOffsetTest(bunnyProg.name());
+            std::cout << member.glslType << " " << names[i] << " :: " << rval[i] << "\n\tGLSL offset : " << offsets[i] << " array stride : " << arrayStrides[i] << " matrix stride : " << matrixStrides[i]
+                << "\n\tClient offset : " << member.offset << " array stride : " << member.arrayStride << " matrix stride : " << member.matrixStride << std::endl;
+        }
+    }
+}
 
-        std::cout << std140::ArrayAlignment<GLfloat>::AlignmentValue << std::endl;
+struct TestStd430Struct : public std430::UBOStruct<>
+{
+    std430::float32_t a;
+    std430::vec2 b;
+    std430::Array<std430::float32_t, 3> c;
+    std430::vec3 d;
+    std430::float32_t e;
+    std430::Array<std430::vec2, 2> f;
+    std430::mat2 g;
+    std430::mat3 h;
+};
 
+// std430 is only available to shader storage blocks, so these are queried through the program interface query api rather than glGetActiveUniformsiv
+struct TestStd430Block
+{
+    std430::Array<std430::float32_t, 5> floats;
+    std430::Array<std430::vec2, 3> vec2s;
+    TestStd430Struct s;
+    std430::float32_t tail;
 
+    static void ssboOffsetTest(GLint program)
+    {
+        TestStd430Block test;
 
-        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
-        TestStruct6::uboOffsetTest(bunnyProg.name());
+        std::cout << "size of TestStd430Struct : " << sizeof(TestStd430Struct) << std::endl;
+        std::cout << "size of TestStd430Block : " << sizeof(TestStd430Block) << std::endl;
 
+        const std::size_t structOff = offsetof(TestStd430Block, s);
 
-        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
-        ActualAppTest(bunnyProg.name());
+        const GLint testUniformCount = 12;
 
-        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
-        TestMatrixStruct::uboOffsetTest(bunnyProg.name());
+        GLint clientOffsets[testUniformCount]
+        {
+            (GLint) offsetof(TestStd430Block, floats),
+            (GLint) offsetof(TestStd430Block, vec2s),
+            (GLint) (structOff + offsetof(TestStd430Struct, a)),
+            (GLint) (structOff + offsetof(TestStd430Struct, b)),
+            (GLint) (structOff + offsetof(TestStd430Struct, c)),
+            (GLint) (structOff + offsetof(TestStd430Struct, d)),
+            (GLint) (structOff + offsetof(TestStd430Struct, e)),
+            (GLint) (structOff + offsetof(TestStd430Struct, f)),
+            (GLint) (structOff + offsetof(TestStd430Struct, g)),
+            (GLint) (structOff + offsetof(TestStd430Struct, h)),
+            (GLint) offsetof(TestStd430Block, tail),
+            (GLint) ((std::size_t) & test.floats[1] - (std::size_t) & test.floats[0]),
+        };
 
+        const GLchar* names[testUniformCount] =
+        {
+            "std430Floats[0]",
+            "std430Vec2s[0]",
+            "std430Struct.a",
+            "std430Struct.b",
+            "std430Struct.c[0]",
+            "std430Struct.d",
+            "std430Struct.e",
+            "std430Struct.f[0]",
+            "std430Struct.g",
+            "std430Struct.h",
+            "std430Tail",
+            "std430Floats[0]",
+        };
 
-        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
-        TestDoubleStruct::uboOffsetTest(bunnyProg.name());
+        // the last entry compares the array stride instead of the offset
+        const GLenum props[testUniformCount] =
+        {
+            GL_OFFSET, GL_OFFSET, GL_OFFSET, GL_OFFSET, GL_OFFSET, GL_OFFSET,
+            GL_OFFSET, GL_OFFSET, GL_OFFSET, GL_OFFSET, GL_OFFSET, GL_ARRAY_STRIDE
+        };
 
+        GLuint rval[testUniformCount] = { 0u };
+        GLint rval2[testUniformCount] = { 0u };
 
-        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
-        TestDoubleStruct2::uboOffsetTest(bunnyProg.name());
+        for (int i = 0; i < testUniformCount; i++)
+        {
+            rval[i] = glGetProgramResourceIndex(program, GL_BUFFER_VARIABLE, names[i]);
+            glGetProgramResourceiv(program, GL_BUFFER_VARIABLE, rval[i], 1, &props[i], 1, nullptr, &rval2[i]);
+        }
+
+        bool passed = true;
+        for (int i = 0; i < testUniformCount; i++)
+        {
+            passed = (rval2[i] == clientOffsets[i]) && passed;
+        }
+
+        std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
+
+        if (!passed || verbose)
+        {
+            for (int i = 0; i < testUniformCount; i++)
+            {
+                std::cout << names[i] << " :: " << rval[i] << "\n\tGLSL offset : " << rval2[i] << "\n\tClient Offset : " << clientOffsets[i] << std::endl;
+            }
+        }
+    }
+};
+
+
+struct RuntimeArrayHeader
+{
+    std430::int32_t nRuntimeStructs;
+};
+
+// unsized trailing array of a shader storage block
+void RuntimeArrayTest(GLint program)
+{
+    typedef std430::RuntimeArray<RuntimeArrayHeader, TestStd430Struct> RuntimeStructs;
+
+    RuntimeStructs test(3);
+    test.header().nRuntimeStructs = 3;
+    test[2].a = 1.0f;
+
+    std::cout << "RuntimeArray<TestStd430Struct> byteSize(3) : " << test.byteSize() << std::endl;
+
+    const GLint testUniformCount = 3;
+
+    GLint clientOffsets[testUniformCount]
+    {
+        (GLint) offsetof(RuntimeArrayHeader, nRuntimeStructs),
+        (GLint) (RuntimeStructs::ArrayOffset + offsetof(TestStd430Struct, a)),
+        (GLint) RuntimeStructs::ElementStride,
+    };
+
+    const GLchar* names[testUniformCount] =
+    {
+        "nRuntimeStructs",
+        "runtimeStructs[0].a",
+        "runtimeStructs[0].a",
+    };
+
+    // the last entry compares the stride of the unsized array
+    const GLenum props[testUniformCount] = { GL_OFFSET, GL_OFFSET, GL_TOP_LEVEL_ARRAY_STRIDE };
+
+    GLuint rval[testUniformCount] = { 0u };
+    GLint rval2[testUniformCount] = { 0u };
+
+    for (int i = 0; i < testUniformCount; i++)
+    {
+        rval[i] = glGetProgramResourceIndex(program, GL_BUFFER_VARIABLE, names[i]);
+        glGetProgramResourceiv(program, GL_BUFFER_VARIABLE, rval[i], 1, &props[i], 1, nullptr, &rval2[i]);
+    }
+
+    bool passed = ((std::size_t) &test[2] - (std::size_t) test.data()) == RuntimeStructs::byteSize(2);
+    for (int i = 0; i < testUniformCount; i++)
+    {
+        passed = (rval2[i] == clientOffsets[i]) && passed;
+    }
+
+    std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
+
+    if (!passed || verbose)
+    {
+        for (int i = 0; i < testUniformCount; i++)
+        {
+            std::cout << names[i] << " :: " << rval[i] << "\n\tGLSL offset : " << rval2[i] << "\n\tClient Offset : " << clientOffsets[i] << std::endl;
+        }
+    }
+}
+
+
+// scalar block layout only exists in Vulkan GLSL, so there is no program to query here
+// the offsets below are worked out by hand from the GL_EXT_scalar_block_layout rules and checked at compile time
+struct TestScalarStruct : public scalar::UBOStruct<>
+{
+    scalar::float32_t a;
+    scalar::vec3 b;
+    scalar::vec2 c;
+    scalar::Array<scalar::vec3, 2> d;
+    scalar::mat3 e;
+    scalar::float32_t f;
+    scalar::dvec2 g;
+};
+
+static_assert(offsetof(TestScalarStruct, a) == 0, "scalar layout : float offset");
+static_assert(offsetof(TestScalarStruct, b) == 4, "scalar layout : vec3 is aligned to its component");
+static_assert(offsetof(TestScalarStruct, c) == 16, "scalar layout : vec3 is 12 bytes");
+static_assert(offsetof(TestScalarStruct, d) == 24, "scalar layout : array is aligned to its element");
+static_assert(offsetof(TestScalarStruct, e) == 48, "scalar layout : vec3 array stride is 12");
+static_assert(offsetof(TestScalarStruct, f) == 84, "scalar layout : mat3 columns are packed");
+static_assert(offsetof(TestScalarStruct, g) == 88, "scalar layout : dvec2 is aligned to double");
+static_assert(sizeof(TestScalarStruct) == 104, "scalar layout : struct size");
+static_assert(sizeof(scalar::Array<scalar::vec3, 5>) == sizeof(float[5][3]), "scalar layout : vec3 arrays match tightly packed host arrays");
+
+
+// the HLSL cbuffer packing rules are also checked at compile time, against offsets worked out by hand from the fxc rules
+struct TestHlslLight : public hlsl_cbuffer::UBOStruct<>
+{
+    hlsl_cbuffer::vec3 direction;
+    hlsl_cbuffer::float32_t intensity;
+    hlsl_cbuffer::vec3 color;
+};
+
+HLSL_CBUFFER_STRUCT_END(TestHlslLight, color);
+HLSL_CBUFFER_CHECK_FOLLOWS(TestHlslLight, direction, intensity);
+HLSL_CBUFFER_CHECK_FOLLOWS(TestHlslLight, intensity, color);
+
+struct TestHlslCBuffer
+{
+    hlsl_cbuffer::float32_t a;
+    hlsl_cbuffer::vec2 b;
+    hlsl_cbuffer::float32_t c;
+    hlsl_cbuffer::Array<hlsl_cbuffer::float32_t, 2> d;
+    hlsl_cbuffer::float32_t e;
+    hlsl_cbuffer::mat3 f;
+    hlsl_cbuffer::float32_t g;
+    hlsl_cbuffer::Struct<TestHlslLight> h;
+    hlsl_cbuffer::float32_t i;
+    hlsl_cbuffer::Array<TestHlslLight, 2> j;
+};
+
+HLSL_CBUFFER_CHECK_FOLLOWS(TestHlslCBuffer, a, b);
+HLSL_CBUFFER_CHECK_FOLLOWS(TestHlslCBuffer, b, c);
+HLSL_CBUFFER_CHECK_FOLLOWS(TestHlslCBuffer, c, d);
+HLSL_CBUFFER_CHECK_FOLLOWS(TestHlslCBuffer, d, e);
+HLSL_CBUFFER_CHECK_FOLLOWS(TestHlslCBuffer, e, f);
+HLSL_CBUFFER_CHECK_FOLLOWS(TestHlslCBuffer, f, g);
+HLSL_CBUFFER_CHECK_FOLLOWS(TestHlslCBuffer, g, h);
+HLSL_CBUFFER_CHECK_FOLLOWS(TestHlslCBuffer, h, i);
+HLSL_CBUFFER_CHECK_FOLLOWS(TestHlslCBuffer, i, j);
+
+static_assert(hlsl_cbuffer::PackedSize<TestHlslLight>::value == 28, "hlsl cbuffer : structs are not padded");
+static_assert(offsetof(TestHlslCBuffer, b) == 4, "hlsl cbuffer : vec2 packs after a float");
+static_assert(offsetof(TestHlslCBuffer, d) == 16, "hlsl cbuffer : arrays start a register");
+static_assert(offsetof(TestHlslCBuffer, e) == 36, "hlsl cbuffer : the last array element is not padded");
+static_assert(offsetof(TestHlslCBuffer, f) == 48, "hlsl cbuffer : matrices start a register");
+static_assert(offsetof(TestHlslCBuffer, g) == 92, "hlsl cbuffer : the last matrix column is not padded");
+static_assert(offsetof(TestHlslCBuffer, h) == 96, "hlsl cbuffer : structs start a register");
+static_assert(offsetof(TestHlslCBuffer, i) == 124, "hlsl cbuffer : members pack into the tail of a struct");
+static_assert(offsetof(TestHlslCBuffer, j) == 128, "hlsl cbuffer : struct arrays start a register");
+static_assert(sizeof(hlsl_cbuffer::Array<TestHlslLight, 2>) == 60, "hlsl cbuffer : struct array stride is 32");
+static_assert(alignof(hlsl_cbuffer::ArrayStorage<hlsl_cbuffer::dvec3, 2>) == alignof(GLdouble) && sizeof(hlsl_cbuffer::dmat2) == 32, "hlsl cbuffer : double elements are aligned without the register alignment");
+
+
+// MSL buffer layout, checked at compile time against offsets worked out by hand from the MSL size and alignment tables
+struct TestMslStruct : public msl::UBOStruct<>
+{
+    msl::float32_t a;
+    msl::vec3 b;
+    msl::float32_t c;
+    msl::packed_vec3 d;
+    msl::vec2 e;
+    msl::Array<msl::float32_t, 3> f;
+    msl::mat3 g;
+    msl::mat2 h;
+    msl::Array<msl::packed_vec3, 2> i;
+};
+
+static_assert(sizeof(msl::vec3) == 16, "msl : float3 is 16 bytes");
+static_assert(offsetof(TestMslStruct, b) == 16, "msl : float3 is 16 aligned");
+static_assert(offsetof(TestMslStruct, c) == 32, "msl : nothing packs into the tail of a float3");
+static_assert(offsetof(TestMslStruct, d) == 36, "msl : packed_float3 is aligned to its component");
+static_assert(offsetof(TestMslStruct, e) == 48, "msl : float2 is 8 aligned");
+static_assert(offsetof(TestMslStruct, f) == 56, "msl : float arrays are aligned to float");
+static_assert(offsetof(TestMslStruct, g) == 80, "msl : float array stride is 4");
+static_assert(offsetof(TestMslStruct, h) == 128, "msl : float3x3 is 48 bytes");
+static_assert(offsetof(TestMslStruct, i) == 144, "msl : float2x2 is 16 bytes");
+static_assert(sizeof(TestMslStruct) == 176, "msl : packed_float3 array stride is 12, struct rounded to 16");
+
+
+// WGSL layouts, checked at compile time against offsets worked out by hand from the WGSL alignment and size rules
+// a struct of one f32 has a stride of 4, so wgsl_uniform::Array<> of it doesn't compile. This one is 16 bytes, aligned to its vec3
+struct TestWgslInner : public wgsl_uniform::UBOStruct<>
+{
+    wgsl_uniform::vec3 x;
+    wgsl_uniform::float32_t y;
+};
+
+struct TestWgslPair : public wgsl_uniform::UBOStruct<>
+{
+    wgsl_uniform::float32_t x;
+    wgsl_uniform::float32_t y;
+};
+
+static_assert(sizeof(TestWgslPair) == 8 && alignof(TestWgslPair) == 4, "wgsl uniform : structs aren't padded out to 16");
+
+struct TestWgslUniform
+{
+    wgsl_uniform::float32_t a;
+    wgsl_uniform::vec2 b;
+    wgsl_uniform::vec3 c;
+    wgsl_uniform::float32_t d;
+    wgsl_uniform::mat2 e;
+    wgsl_uniform::Array<wgsl_uniform::vec4, 2> f;
+    wgsl_uniform::Array<TestWgslInner, 2> g;
+    wgsl_uniform::float32_t h;
+};
+
+static_assert(offsetof(TestWgslUniform, b) == 8, "wgsl uniform : vec2 is 8 aligned");
+static_assert(offsetof(TestWgslUniform, c) == 16, "wgsl uniform : vec3 is 16 aligned");
+static_assert(offsetof(TestWgslUniform, d) == 28, "wgsl uniform : vec3 is 12 bytes");
+static_assert(offsetof(TestWgslUniform, e) == 32, "wgsl uniform : mat2x2 is 8 aligned");
+static_assert(offsetof(TestWgslUniform, f) == 48, "wgsl uniform : mat2x2 is 16 bytes");
+static_assert(offsetof(TestWgslUniform, g) == 80, "wgsl uniform : vec4 array stride is 16");
+static_assert(offsetof(TestWgslUniform, h) == 112, "wgsl uniform : struct array stride is the struct size");
+
+struct TestWgslStorageInner : public wgsl_storage::UBOStruct<>
+{
+    wgsl_storage::float32_t x;
+};
+
+struct TestWgslStorage
+{
+    wgsl_storage::float32_t a;
+    wgsl_storage::Array<wgsl_storage::float32_t, 3> b;
+    wgsl_storage::vec3 c;
+    wgsl_storage::mat3 d;
+    wgsl_storage::Array<wgsl_storage::vec2, 2> e;
+    wgsl_storage::Array<TestWgslStorageInner, 3> f;
+    wgsl_storage::float32_t g;
+};
+
+static_assert(offsetof(TestWgslStorage, b) == 4, "wgsl storage : f32 arrays are 4 aligned");
+static_assert(offsetof(TestWgslStorage, c) == 16, "wgsl storage : f32 array stride is 4");
+static_assert(offsetof(TestWgslStorage, d) == 32, "wgsl storage : mat3x3 is 16 aligned");
+static_assert(offsetof(TestWgslStorage, e) == 80, "wgsl storage : mat3x3 is 48 bytes");
+static_assert(offsetof(TestWgslStorage, f) == 96, "wgsl storage : vec2 array stride is 8");
+static_assert(offsetof(TestWgslStorage, g) == 108, "wgsl storage : struct array stride is 4");
+
+
+// one block declared once, instantiated in several layouts
+template <typename L>
+struct TestTranscodeLight : public L::template UBOStruct<>
+{
+    typename L::vec3 direction;
+    typename L::float32_t intensity;
+    typename L::vec3 color;
+    typename L::template Array<typename L::float32_t, 8> weights;
+    typename L::mat3 rotation;
+    typename L::int32_t index;
+
+    UBO_MEMBERS(TestTranscodeLight, direction, intensity, color, weights, rotation, index)
+};
+
+template <typename L>
+struct TestTranscodeBlock
+{
+    typename L::int32_t nLights;
+    typename L::template Array<TestTranscodeLight<L>, 4> lights;
+
+    UBO_MEMBERS(TestTranscodeBlock, nLights, lights)
+};
+
+// direction through weights are contiguous in both std430 and scalar, so they are a single run, then one run per mat3 column and one for index
+static_assert(std140::Transcoder<TestTranscodeLight<std430::Layout>, TestTranscodeLight<scalar::Layout> >::RunCount == 5, "transcoder : coalesced runs");
+
+// round trips the tight host layout through std140 and std430 and checks nothing was lost
+void TranscodeTest()
+{
+    TestTranscodeBlock<scalar::Layout> host{};
+
+    host.nLights = 4;
+    for (int i = 0; i < 4; i++)
+    {
+        host.lights[i].direction = { { 1.0f, 2.0f, float(i) } };
+        host.lights[i].intensity = 0.5f * i;
+        host.lights[i].color = { { 0.25f, 0.5f, 0.75f } };
+        for (int j = 0; j < 8; j++)
+        {
+            host.lights[i].weights[j] = float(i * j);
+        }
+        host.lights[i].rotation[2][1] = 3.0f;
+        host.lights[i].index = i;
+    }
+
+    TestTranscodeBlock<std140::Layout> upload{};
+    TestTranscodeBlock<std430::Layout> storage{};
+    TestTranscodeBlock<scalar::Layout> roundTrip{};
+
+    std140::transcode(host, upload);
+    std140::transcode(upload, storage);
+    std140::transcode(storage, roundTrip);
+
+    typedef std140::Transcoder<TestTranscodeBlock<scalar::Layout>, TestTranscodeBlock<std140::Layout> > HostToUpload;
+
+    std::cout << "scalar block " << sizeof(host) << " bytes, std140 block " << sizeof(upload) << " bytes, std430 block " << sizeof(storage) << " bytes" << std::endl;
+    std::cout << "scalar -> std140 : " << HostToUpload::RunCount << " memcpy runs, " << HostToUpload::copiedBytes() << " bytes" << std::endl;
+
+    bool passed = std::memcmp(&host, &roundTrip, sizeof(host)) == 0;
+    passed = upload.lights[3].weights[7] == 21.0f && passed;
+    passed = upload.lights[2].rotation[2][1] == 3.0f && passed;
+    passed = storage.lights[3].index == 3 && passed;
+
+    std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+
+// the per instance attributes of bunnyVert
+struct TestInstanceAttributes : public vertex_attrib::UBOStruct<>
+{
+    vertex_attrib::mat4 objectMatrix;
+    vertex_attrib::mat3 normalMatrix;
+
+    UBO_MEMBERS(TestInstanceAttributes, objectMatrix, normalMatrix)
+};
+
+static_assert(sizeof(TestInstanceAttributes) == 100, "vertex attributes : tightly packed");
+static_assert(vertex_attrib::locationCount<TestInstanceAttributes>() == 7, "vertex attributes : one location per matrix column");
+static_assert(vertex_attrib::attributeDescriptors<TestInstanceAttributes>(1)[4].location == 5, "vertex attributes : normalMatrix follows objectMatrix");
+static_assert(vertex_attrib::attributeDescriptors<TestInstanceAttributes>(1)[4].offset == 64, "vertex attributes : normalMatrix offset");
+static_assert(vertex_attrib::attributeDescriptors<TestInstanceAttributes>(1)[6].offset == 88, "vertex attributes : mat3 columns are 12 bytes apart");
+static_assert(vertex_attrib::attributeDescriptors<TestInstanceAttributes>(1)[6].components == 3, "vertex attributes : mat3 columns are vec3s");
+
+// dvec3 and dvec4 values take two locations each, but still one descriptor
+struct TestDoubleAttributes : public vertex_attrib::UBOStruct<>
+{
+    vertex_attrib::dmat3 m;
+    vertex_attrib::Array<vertex_attrib::dvec4, 2> a;
+
+    UBO_MEMBERS(TestDoubleAttributes, m, a)
+};
+
+template <typename T>
+constexpr bool attributesNamed()
+{
+    for (const vertex_attrib::AttributeDescriptor& attribute : vertex_attrib::attributeDescriptors<T>())
+    {
+        if (attribute.name == nullptr || attribute.components == 0)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static_assert(vertex_attrib::attributeCount<TestDoubleAttributes>() == 5 && vertex_attrib::locationCount<TestDoubleAttributes>() == 10, "vertex attributes : one descriptor per double column and element");
+static_assert(attributesNamed<TestDoubleAttributes>() && attributesNamed<TestInstanceAttributes>(), "vertex attributes : no empty descriptors");
+static_assert(vertex_attrib::attributeDescriptors<TestDoubleAttributes>(1)[3].location == 7 && vertex_attrib::attributeDescriptors<TestDoubleAttributes>(1)[4].location == 9, "vertex attributes : dvec4 elements take two locations");
+
+// compares the generated locations against the locations the program was linked with
+void InstanceAttributeTest(GLint program)
+{
+    constexpr auto descriptors = vertex_attrib::attributeDescriptors<TestInstanceAttributes>(1);
+
+    const GLint testUniformCount = 2;
+
+    GLint clientLocations[testUniformCount]
+    {
+        (GLint) descriptors[0].location,
+        (GLint) descriptors[4].location,
+    };
+
+    const GLchar* names[testUniformCount] =
+    {
+        "objectMatrix",
+        "normalMatrix",
+    };
+
+    GLint rval[testUniformCount] = { 0 };
+
+    for (int i = 0; i < testUniformCount; i++)
+    {
+        rval[i] = glGetAttribLocation(program, names[i]);
+    }
+
+    bool passed = true;
+    for (int i = 0; i < testUniformCount; i++)
+    {
+        passed = (rval[i] == clientLocations[i]) && passed;
+    }
+
+    std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
+
+    if (!passed || verbose)
+    {
+        for (const vertex_attrib::AttributeDescriptor& attribute : descriptors)
+        {
+            std::cout << attribute.name << " :: location " << attribute.location << " components " << attribute.components << " offset " << attribute.offset << " stride " << attribute.stride << std::endl;
+        }
+
+        for (int i = 0; i < testUniformCount; i++)
+        {
+            std::cout << names[i] << "\n\tGLSL location : " << rval[i] << "\n\tClient location : " << clientLocations[i] << std::endl;
+        }
+    }
+}
+
+
+#include "testshaders.h"
+//#include <Virtuoso/GL/GLFWApplication.h>
+
+// the blocks of the test shader, parsed at compile time. Any drift between these structs and bunnyFrag fails the build
+constexpr std140::GlslShader bunnyFragLayout = std140::parseGlsl(bunnyFragSource);
+
+static_assert(bunnyFragLayout.ok(), "glsl parser : bunnyFrag parses");
+static_assert(std140::layoutMatches<TestMatrixStruct>(bunnyFragLayout, "MatrixStruct"), "glsl parser : TestMatrixStruct matches MatrixStruct");
+static_assert(std140::layoutMatches<TestBoolStruct>(bunnyFragLayout, "BoolStruct"), "glsl parser : TestBoolStruct matches BoolStruct");
+static_assert(bunnyFragLayout.offsetOf("TestInstancesUBO4", "testInstances4[1].d[2]") == sizeof(TestStruct4) + offsetof(TestStruct4, d) + 2 * 16, "glsl parser : nested array offsets");
+static_assert(bunnyFragLayout.offsetOf("DoubleUBO2", "testDoubleStruct2[1].b") == sizeof(TestDoubleStruct2) + offsetof(TestDoubleStruct2, b), "glsl parser : dvec3 offsets");
+static_assert(bunnyFragLayout.offsetOf("Std430Block", "std430Struct.h") == offsetof(TestStd430Block, s) + offsetof(TestStd430Struct, h), "glsl parser : std430 offsets");
+static_assert(!std140::parseGlsl("struct S { mat2 m; }; layout(std140) uniform B { layout(row_major) S s; };").ok(), "glsl parser : row_major can't reach into a struct's unqualified matrices");
+static_assert(std140::parseGlsl("struct S { layout(column_major) mat2 m; }; layout(std140) uniform B { layout(row_major) S s; };").ok(), "glsl parser : row_major on a struct with qualified matrices");
+
+// default layout statements apply to the blocks after them, uniform and buffer blocks separately
+constexpr std140::GlslShader defaultLayouts = std140::parseGlsl(
+    "layout(std140) uniform; layout(std430) buffer; uniform A { vec3 a; float b; }; layout(row_major) uniform; uniform B { mat2x3 m; }; buffer C { float c[2]; };");
+
+static_assert(defaultLayouts.ok() && defaultLayouts.blockCount == 3, "glsl parser : default layout statements aren't blocks");
+static_assert(defaultLayouts.blocks[0].layout == std140::GlslLayout::Std140 && defaultLayouts.offsetOf("A", "b") == 12, "glsl parser : default uniform layout");
+static_assert(defaultLayouts.blocks[1].layout == std140::GlslLayout::Std140 && defaultLayouts.fields[defaultLayouts.blocks[1].firstField].rowMajor, "glsl parser : default majorness keeps the default layout");
+static_assert(defaultLayouts.blocks[2].layout == std140::GlslLayout::Std430 && defaultLayouts.offsetOf("C", "c[1]") == 4, "glsl parser : default buffer layout");
+static_assert(!std140::parseGlsl("layout(std140) uniform 4;").ok(), "glsl parser : unexpected tokens after uniform are errors");
+
+// the generated light structs are checked against the source they were generated from, so a stale header fails the build too
+constexpr std140::GlslShader pbrLightsLayout = std140::parseGlsl(pbr_lights::glslSource);
+
+static_assert(pbrLightsLayout.define("MAX_POINT_LIGHTS") == MAX_POINT_LIGHTS, "glsl parser : MAX_POINT_LIGHTS matches");
+static_assert(pbrLightsLayout.define("MAX_DIRECTIONAL_LIGHTS") == MAX_DIRECTIONAL_LIGHTS, "glsl parser : MAX_DIRECTIONAL_LIGHTS matches");
+static_assert(std140::layoutMatches<PointLightUBO>(pbrLightsLayout, "PointLightBlock"), "glsl parser : PointLightUBO matches PointLightBlock");
+static_assert(std140::layoutMatches<DirectionalLightUBO>(pbrLightsLayout, "DirectionalLightBlock"), "glsl parser : DirectionalLightUBO matches DirectionalLightBlock");
+static_assert(std140::layoutMatches<SphereUBO>(pbrLightsLayout, "SphereInstances"), "glsl parser : SphereUBO matches SphereInstances");
+
+// InstanceMaterial keeps its floats in the vec3 tails, so there is nothing left to gain. With the floats first it takes 16 more bytes per sphere
+constexpr std140::GlslShader unpackedMaterial = std140::parseGlsl("struct M { float roughness; float metallic; vec3 surfaceColor; vec3 emissive; };");
+
+static_assert(std140::planLayout(pbrLightsLayout, "InstanceMaterial").savedBytes() == 0, "layout planner : InstanceMaterial is packed");
+static_assert(std140::planLayout(unpackedMaterial, "M").originalSize == 48 && std140::planLayout(unpackedMaterial, "M").size == 32, "layout planner : the floats go in the vec3 tails");
+static_assert(std140::planLayout(pbrLightsLayout, "DirectionalLight").size == sizeof(DirectionalLight), "layout planner : two vec3s can't be packed tighter");
+
+// what std140plan --check checks : nothing in the shipped shader can shrink, counting blocks at their rounded up size
+template <typename Shader>
+constexpr bool nothingShrinks(const Shader& shader)
+{
+    for (std::size_t s = 0; s < shader.structCount; s++)
+    {
+        if (std140::planLayout(shader, shader.structs[s].name).savedBytes())
+        {
+            return false;
+        }
+    }
+
+    for (std::size_t b = 0; b < shader.blockCount; b++)
+    {
+        if (std140::planLayout(shader, shader.blocks[b].name).savedBytes())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+static_assert(nothingShrinks(pbrLightsLayout), "layout planner : pbr_lights.glsl passes std140plan --check");
+static_assert(std140::planLayout(pbrLightsLayout, "PointLightBlock").size == sizeof(PointLightUBO), "layout planner : blocks are as large as their structs");
+static_assert(std140::planLayout(std140::parseGlsl("layout(std140) uniform B { float a; vec4 v; float b; };"), "B").savedBytes() == 16, "layout planner : blocks still shrink by whole vec4s");
+
+static_assert(std140::usefulBytes<std140::Array<std140::float32_t, 4> >() == 16 && sizeof(std140::Array<std140::float32_t, 4>) == 64, "padding report : float arrays are three quarters padding");
+static_assert(std140::usefulBytes<std140::mat3>() == 36 && std140::usefulBytes<std140::bvec3>() == 12, "padding report : matrix columns and vectors count their components");
+static_assert(std140::paddingTable<PointLightUBO>().members[0].paddingBytes() == 12, "padding report : the count pads out to the array");
+static_assert(std140::paddingTable<PointLightUBO>().members[1].elementUsefulBytes == 24 && std140::paddingTable<PointLightUBO>().members[1].arrayStride == 32, "padding report : per element bytes");
+static_assert(std140::paddingTable<SphereUBO>().paddingBytes() == 0, "padding report : InstanceMaterial has no padding");
+
+static_assert(std140::vec4Count<PointLightUBO>() == 1 + 2 * MAX_POINT_LIGHTS, "vec4 pack : one slot for the count, two per light");
+
+struct Vec4PackIntegers : public std140::UBOStruct<>
+{
+    std140::int32_t count = 0;
+    std140::uint32_t flags = 0u;
+    std140::bvec2 enabled;
+    std140::Array<std140::ivec2, 2> cells;
+
+    UBO_MEMBERS(Vec4PackIntegers, count, flags, enabled, cells)
+};
+
+// compiles the generated accessors, uploads a PointLightUBO with one glUniform4fv and reads it back through the uniform array
+void Vec4PackTest()
+{
+    const std::string vert = "#version 410 core\n" + std140::vec4ArrayGlsl<PointLightUBO>("u_lights") +
+        "void main()\n"
+        "{\n"
+        "    PointLight light = u_lights_pointLights(gl_InstanceID % u_lights_nPointLights());\n"
+        "    gl_Position = vec4(light.location + light.color, 1.0);\n"
+        "}\n";
+
+    const std::string frag = "#version 410 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n";
+
+    gl::Program program(
+        Virtuoso::GL::Program(
+            {
+                Virtuoso::GL::Shader(GL_VERTEX_SHADER, vert),
+                Virtuoso::GL::Shader(GL_FRAGMENT_SHADER, frag)
+            }
+    ));
+
+    PointLightUBO lights;
+    lights.nPointLights = 3;
+    lights.pointLights[1].location = { 1.0f, 2.0f, 3.0f };
+    lights.pointLights[1].color = { 4.0f, 5.0f, 6.0f };
+
+    glUseProgram(program.name());
+    std140::uploadVec4Array(glGetUniformLocation(program.name(), "u_lights"), lights);
+
+    GLfloat count[4] = { 0.0f };
+    GLfloat location[4] = { 0.0f };
+    GLfloat color[4] = { 0.0f };
+
+    // the count is stored as a float value, the lights start at slot 1 and take 2 slots each
+    glGetUniformfv(program.name(), glGetUniformLocation(program.name(), "u_lights[0]"), count);
+    glGetUniformfv(program.name(), glGetUniformLocation(program.name(), "u_lights[3]"), location);
+    glGetUniformfv(program.name(), glGetUniformLocation(program.name(), "u_lights[4]"), color);
+
+    glUseProgram(0);
+
+    // integers and bools are packed as float values, not bit patterns
+    Vec4PackIntegers integers;
+    integers.count = -5;
+    integers.flags = 7u;
+    integers.enabled[1] = true;
+    integers.cells[1] = { 100, 16777216 };
+
+    std140::Vec4Image<Vec4PackIntegers> image;
+    std140::packVec4(integers, image);
+
+    const bool packed = image[0][0] == -5.0f && image[0][1] == 7.0f && image[0][2] == 0.0f && image[0][3] == 1.0f &&
+        image[2][0] == 100.0f && image[2][1] == 16777216.0f;
+
+    const std::string integerGlsl = std140::vec4ArrayGlsl<Vec4PackIntegers>("u_integers");
+
+    const bool passed = packed && count[0] == 3.0f && integerGlsl.find("floatBitsTo") == std::string::npos &&
+        location[0] == 1.0f && location[1] == 2.0f && location[2] == 3.0f &&
+        color[0] == 4.0f && color[1] == 5.0f && color[2] == 6.0f;
+
+    std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
+
+    if (!passed || verbose)
+    {
+        std::cout << vert << std::endl;
+        std::cout << integerGlsl << std::endl;
+        std::cout << "nPointLights : " << count[0] << "\n\tpointLights[1].location : " << location[0] << " " << location[1] << " " << location[2]
+            << "\n\tpointLights[1].color : " << color[0] << " " << color[1] << " " << color[2] << std::endl;
+    }
+}
+
+struct TestEmitterStruct : public std140::UBOStruct<>
+{
+    std140::vec3 a;
+    std140::float32_t b;
+    std140::Array<PointLight, 3> lights;
+    std140::Matrix<float, 3, 2, false> c;
+    std140::Array<std140::mat2, 2> d;
+    std140::bvec2 f;
+
+    UBO_MEMBERS(TestEmitterStruct, a, b, lights, c, d, f)
+};
+
+struct TestEmitterUBO
+{
+    TestEmitterStruct emitted;
+    std140::int32_t count;
+    std140::Array<PointLight, 2> more;
+
+    UBO_MEMBERS(TestEmitterUBO, emitted, count, more)
+};
+
+// builds a shader from the block glslUniformBlock() emits for TestEmitterUBO, and checks the driver's offsets against the C++ ones
+void EmitterTest()
+{
+    const std::string block = std140::glslUniformBlock<TestEmitterUBO>("EmitterBlock");
+
+    // the parser reads the emitted text back to the same layout
+    const std140::GlslShader parsed = std140::parseGlsl(block);
+    const bool roundTrip = parsed.ok() && std140::layoutMatches<TestEmitterUBO>(parsed, "EmitterBlock") && std140::layoutMatches<TestEmitterStruct>(parsed, "TestEmitterStruct");
+
+    const std::string vert = "#version 410 core\n" + block +
+        "void main()\n"
+        "{\n"
+        "    vec3 p = emitted.a * emitted.b + emitted.lights[count].color + more[count].location;\n"
+        "    p.xy += emitted.c * p + emitted.d[count] * p.xy;\n"
+        "    gl_Position = vec4(p, emitted.f.y ? 1.0 : 0.0);\n"
+        "}\n";
+
+    const std::string frag = "#version 410 core\nout vec4 color;\nvoid main() { color = vec4(1.0); }\n";
+
+    gl::Program program(
+        Virtuoso::GL::Program(
+            {
+                Virtuoso::GL::Shader(GL_VERTEX_SHADER, vert),
+                Virtuoso::GL::Shader(GL_FRAGMENT_SHADER, frag)
+            }
+    ));
+
+    const GLint testUniformCount = 8;
+
+    const GLint clientOffsets[testUniformCount]
+    {
+        (GLint) offsetof(TestEmitterStruct, a),
+        (GLint) offsetof(TestEmitterStruct, b),
+        (GLint) (offsetof(TestEmitterStruct, lights) + sizeof(PointLight) + offsetof(PointLight, color)),
+        (GLint) offsetof(TestEmitterStruct, c),
+        (GLint) (offsetof(TestEmitterStruct, d) + sizeof(std140::mat2)),
+        (GLint) offsetof(TestEmitterStruct, f),
+        (GLint) offsetof(TestEmitterUBO, count),
+        (GLint) (offsetof(TestEmitterUBO, more) + sizeof(PointLight) + offsetof(PointLight, location))
+    };
+
+    const GLchar* names[testUniformCount] =
+    {
+        "emitted.a",
+        "emitted.b",
+        "emitted.lights[1].color",
+        "emitted.c",
+        "emitted.d[1]",
+        "emitted.f",
+        "count",
+        "more[1].location"
+    };
+
+    GLuint rval[testUniformCount] = { 0u };
+    GLint offsets[testUniformCount] = { 0 };
+    GLint rowMajor[testUniformCount] = { 0 };
+
+    glGetUniformIndices(program.name(), testUniformCount, names, rval);
+    glGetActiveUniformsiv(program.name(), testUniformCount, rval, GL_UNIFORM_OFFSET, offsets);
+    glGetActiveUniformsiv(program.name(), testUniformCount, rval, GL_UNIFORM_IS_ROW_MAJOR, rowMajor);
+
+    bool passed = roundTrip && rowMajor[3] == GL_TRUE && rowMajor[4] == GL_FALSE;
+    for (int i = 0; i < testUniformCount; i++)
+    {
+        passed = (offsets[i] == clientOffsets[i]) && passed;
+    }
+
+    std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
+
+    if (!passed || verbose)
+    {
+        std::cout << block << std::endl;
+        std::cout << "parsed back : " << (roundTrip ? "matches" : "differs") << std::endl;
+
+        for (int i = 0; i < testUniformCount; i++)
+        {
+            std::cout << names[i] << " :: " << rval[i] << "\n\tGLSL offset : " << offsets[i] << "\n\tClient offset : " << clientOffsets[i] << std::endl;
+        }
+    }
+}
+
+struct TestDynamicStruct : public std140::UBOStruct<std140::dvec4>
+{
+    std140::float32_t a;
+    std140::vec3 b;
+    std140::float32_t c;
+    std140::Array<std140::float32_t, 3> d;
+    std140::mat3 e;
+    std140::Array<std140::vec2, 2> f;
+    std140::ivec3 g;
+    std140::uint32_t h;
+    std140::dvec2 i;
+    std140::Array<std140::mat2x3, 2> j;
+    std140::bvec2 k;
+    std140::Array<std140::dvec3, 2> l;
+    std140::dmat3 m;
+    std140::dmat2x3 n;
+
+    UBO_MEMBERS(TestDynamicStruct, a, b, c, d, e, f, g, h, i, j, k, l, m, n)
+};
+
+// a DynamicLayout built from the reflection table of T, ie. the schema a content file would give for T
+template <typename T>
+std140::DynamicLayout dynamicLayoutOf()
+{
+    std140::DynamicLayout layout;
+
+    for (const std140::MemberInfo& member : std140::reflect<T>())
+    {
+        layout.add(member.name, member.glslType, member.arrayLength);
+    }
+
+    return layout;
+}
+
+template <typename T>
+bool dynamicLayoutMatches(const std140::DynamicLayout& layout)
+{
+    constexpr auto table = std140::reflect<T>();
+
+    bool passed = layout.members().size() == table.size();
+
+    for (std::size_t i = 0; passed && i < table.size(); i++)
+    {
+        const std140::DynamicMember& member = layout.members()[i];
+
+        passed = member.offset == table[i].offset && member.arrayStride == table[i].arrayStride && member.matrixStride == table[i].matrixStride;
+
+        if (!passed || verbose)
+        {
+            std::cout << table[i].glslType << " " << member.name << "\n\tdynamic offset : " << member.offset << " array stride : " << member.arrayStride << " matrix stride : " << member.matrixStride
+                << "\n\tstatic offset : " << table[i].offset << " array stride : " << table[i].arrayStride << " matrix stride : " << table[i].matrixStride << std::endl;
+        }
+    }
+
+    return passed;
+}
+
+// lays out the test structs from their schemas at run time, and fills a dynamic block through setters to compare it byte for byte with the static one
+void DynamicLayoutTest()
+{
+    const std140::DynamicLayout layout = dynamicLayoutOf<TestDynamicStruct>();
+
+    bool passed = dynamicLayoutMatches<TestDynamicStruct>(layout) &&
+        dynamicLayoutMatches<TestMatrixStruct>(dynamicLayoutOf<TestMatrixStruct>()) &&
+        dynamicLayoutMatches<TestBoolStruct>(dynamicLayoutOf<TestBoolStruct>());
+
+    TestDynamicStruct expected{};
+    expected.b = { { 1.0f, 2.0f, 3.0f } };
+    expected.c = 4.0f;
+    expected.d[2] = 5.0f;
+    expected.e[1] = { { 6.0f, 7.0f, 8.0f } };
+    expected.h = 9u;
+    expected.j[1][0] = { { 10.0f, 11.0f, 12.0f } };
+    expected.k = { { true, false } };
+    expected.l[1] = { { 13.0, 14.0, 15.0 } };
+    expected.m[2] = { { 16.0, 17.0, 18.0 } };
+
+    std::vector<unsigned char> block(sizeof(TestDynamicStruct), 0);
+
+    const auto b = layout.setter<std140::vec3>("b");
+    const auto c = layout.setter<std140::float32_t>("c");
+    const auto d = layout.setter<std140::float32_t>("d");
+    const auto e = layout.setter<std140::mat3>("e");
+    const auto h = layout.setter<std140::uint32_t>("h");
+    const auto j = layout.setter<std140::mat2x3>("j");
+    const auto k = layout.setter<std140::bvec2>("k");
+    const auto l = layout.setter<std140::dvec3>("l");
+    const auto m = layout.setter<std140::dmat3>("m");
+
+    passed = passed && b.valid() && c.valid() && d.valid() && e.valid() && h.valid() && j.valid() && k.valid() && l.valid() && m.valid() &&
+        layout.size() == sizeof(TestDynamicStruct) && !layout.setter<std140::vec4>("b").valid() && !layout.setter<std140::float32_t>("missing").valid() && layout.size() <= block.size();
+
+    if (passed)
+    {
+        b.set(block.data(), expected.b);
+        c.set(block.data(), expected.c);
+        d.set(block.data(), 2, 5.0f);
+        e.set(block.data(), expected.e);
+        h.set(block.data(), expected.h);
+        j.set(block.data(), 1, expected.j[1]);
+        k.set(block.data(), expected.k);
+        l.set(block.data(), 1, expected.l[1]);
+        m.set(block.data(), expected.m);
+
+        passed = std::memcmp(block.data(), &expected, layout.size()) == 0;
+    }
+
+    std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+// reloads a material schema with members reordered, an array grown and a member added, and moves a batch of blocks over to it
+void LayoutMigrationTest()
+{
+    std140::DynamicLayout before;
+    before.add("roughness", "float");
+    before.add("surfaceColor", "vec3");
+    before.add("weights", "float", 4);
+    before.add("tint", "mat3");
+
+    std140::DynamicLayout after;
+    after.add("surfaceColor", "vec3");
+    after.add("roughness", "float");
+    after.add("weights", "float", 6);
+    after.add("metallic", "float");
+    after.add("tint", "mat3");
+
+    const std140::MigrationPlan plan = std140::planMigration(std140::migrationLeaves(before), std140::migrationLeaves(after));
+
+    // surfaceColor and roughness swap, the old weights and tint each move in one piece, the new weights and metallic are one fill
+    bool passed = plan.copies.size() == 4 && plan.defaults.size() == 1 && plan.keptLeaves == 9 && plan.addedLeaves == 3 && plan.droppedLeaves == 0;
+
+    const std::size_t count = 1000;
+    std::vector<unsigned char> oldBlocks(count * before.size(), 0);
+    std::vector<unsigned char> newBlocks(count * after.size(), 0);
+    std::vector<unsigned char> defaults(after.size(), 0);
+
+    const auto oldRoughness = before.setter<std140::float32_t>("roughness");
+    const auto oldColor = before.setter<std140::vec3>("surfaceColor");
+    const auto oldWeights = before.setter<std140::float32_t>("weights");
+    const auto oldTint = before.setter<std140::mat3>("tint");
+
+    after.setter<std140::float32_t>("metallic").set(defaults.data(), 0.5f);
+    after.setter<std140::float32_t>("weights").set(defaults.data(), 5, 1.0f);
+
+    for (std::size_t i = 0; i < count; i++)
+    {
+        unsigned char* block = oldBlocks.data() + i * before.size();
+        const float f = float(i);
+
+        std140::mat3 tint;
+        tint[0] = { { f, 1.0f, 2.0f } };
+        tint[1] = { { 3.0f, f, 4.0f } };
+        tint[2] = { { 5.0f, 6.0f, f } };
+
+        oldRoughness.set(block, f);
+        oldColor.set(block, { { f, f + 1.0f, f + 2.0f } });
+        oldWeights.set(block, 3, f * 2.0f);
+        oldTint.set(block, tint);
+    }
+
+    plan.apply(oldBlocks.data(), before.size(), newBlocks.data(), after.size(), count, defaults.data());
+
+    const std140::DynamicMember& roughness = after.members()[after.find("roughness")];
+    const std140::DynamicMember& color = after.members()[after.find("surfaceColor")];
+    const std140::DynamicMember& weights = after.members()[after.find("weights")];
+    const std140::DynamicMember& metallic = after.members()[after.find("metallic")];
+    const std140::DynamicMember& tint = after.members()[after.find("tint")];
+
+    for (std::size_t i = 0; i < count && passed; i++)
+    {
+        const unsigned char* block = newBlocks.data() + i * after.size();
+        const auto value = [block](std::size_t offset) { float v; std::memcpy(&v, block + offset, sizeof(v)); return v; };
+        const float f = float(i);
+
+        passed = value(roughness.offset) == f && value(color.offset + 8) == f + 2.0f &&
+            value(weights.offset + 3 * weights.arrayStride) == f * 2.0f && value(weights.offset + 5 * weights.arrayStride) == 1.0f &&
+            value(metallic.offset) == 0.5f && value(tint.offset + 2 * tint.matrixStride + 8) == f && value(tint.offset + tint.matrixStride) == 3.0f;
+    }
+
+    // the same for a block reparsed from GLSL, where a float fills the tail of a vec3 and the row_major matrix can't keep its rows
+    static std140::GlslShader oldShader;
+    static std140::GlslShader newShader;
+    std140::parseGlsl("layout(std140) uniform Block { vec4 a; vec3 b; mat4 m; layout(row_major) mat2 r; };", oldShader);
+    std140::parseGlsl("layout(std140) uniform Block { vec4 a; vec3 b; float c; mat4 m; mat2 r; };", newShader);
+
+    const std140::MigrationPlan reload = std140::planMigration(std140::migrationLeaves(oldShader, "Block"), std140::migrationLeaves(newShader, "Block"));
+
+    // the new float ends the copy run, rather than being copied from the old padding and then overwritten
+    passed = passed && oldShader.ok() && newShader.ok() && reload.copies.size() == 2 && reload.copies[0].size == 28 && reload.copies[1].size == 64 &&
+        reload.defaults.size() == 2 && reload.defaults[0].to == 28 && reload.addedLeaves == 3 && reload.droppedLeaves == 2;
+
+    // no copy writes over a default, so the order apply() writes them in doesn't matter
+    for (const std140::MigrationPlan* p : { &plan, &reload })
+    {
+        for (const std140::MigrationCopy& copy : p->copies)
+        {
+            for (const std140::MigrationCopy& fill : p->defaults)
+            {
+                passed = passed && (copy.to + copy.size <= fill.to || fill.to + fill.size <= copy.to);
+            }
+        }
+    }
+
+    std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+// moves a few of the PBR demo's lights through a tracked block and checks only their bytes come back from flush()
+void TrackedTest()
+{
+    std140::Tracked<PointLightUBO> lights;
+
+    // a new block is uploaded whole first
+    const std::vector<std140::MemberRange> initial = lights.flush();
+    bool passed = initial.size() == 1 && initial[0].offset == 0 && initial[0].size == sizeof(PointLightUBO) && lights->nPointLights == 0;
+
+    lights.set(lights->nPointLights, 4);
+    lights.edit(lights->pointLights[3].location) = { { 1.0f, 2.0f, 3.0f } };
+    lights.set(lights->pointLights[5].color, std140::vec3{ { 0.5f, 0.5f, 0.5f } });
+    lights.edit(lights->pointLights[4]).color = { { 1.0f, 1.0f, 1.0f } };
+    lights.edit(lights->pointLights[4].location);
+    lights.edit(lights->pointLights[3].location);
+
+    constexpr std140::MemberRange count = std140::range_of<PointLightUBO>("nPointLights");
+    constexpr std140::MemberRange light3 = std140::range_of<PointLightUBO>("pointLights[3].location");
+    constexpr std140::MemberRange light4 = std140::range_of<PointLightUBO>("pointLights[4]");
+    constexpr std140::MemberRange light5 = std140::range_of<PointLightUBO>("pointLights[5].color");
+
+    // repeated and overlapping writes collapse, the padding between members keeps the rest apart
+    const std::vector<std140::MemberRange> exact = lights.flush();
+    const std140::MemberRange expected[4] = { count, light3, light4, light5 };
+
+    passed = passed && exact.size() == 4 && lights->nPointLights == 4 && lights->pointLights[3].location[2] == 3.0f && lights->pointLights[5].color[0] == 0.5f;
+
+    for (std::size_t i = 0; i < exact.size() && passed; i++)
+    {
+        passed = exact[i].offset == expected[i].offset && exact[i].size == expected[i].size;
+    }
+
+    passed = passed && !lights.dirty() && lights.flush().empty();
+
+    // light 3's color and light 4's location are 4 bytes of vec3 padding apart, which a gap joins
+    lights.edit(lights->pointLights[4].location);
+    lights.edit(lights->pointLights[3].color);
+
+    const std::vector<std140::MemberRange>& joined = lights.flush(16);
+    passed = passed && joined.size() == 1 && joined[0].offset == std140::offset_of<PointLightUBO>("pointLights[3].color") &&
+        joined[0].offset + joined[0].size == light4.offset + 12;
+
+    lights.set(PointLightUBO());
+    passed = passed && lights.flush().size() == 1 && lights.flush().empty();
+
+    std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+// snaps dirty ranges to the members of the light block and joins them as the cost model says
+void RangeCoalescerTest()
+{
+    constexpr auto leaves = std140::memberLeaves<PointLightUBO>();
+    static_assert(leaves.size() == 1 + 2 * pbr_lights::MAX_POINT_LIGHTS, "a leaf per int and vec3");
+
+    constexpr std140::MemberRange location1 = std140::range_of<PointLightUBO>("pointLights[1].location");
+    constexpr std140::MemberRange color1 = std140::range_of<PointLightUBO>("pointLights[1].color");
+    constexpr std140::MemberRange light8 = std140::range_of<PointLightUBO>("pointLights[8]");
+
+    // calls worth 100 bytes : light 1's members join, light 8 is too far away
+    std140::RangeCoalescer coalescer = std140::RangeCoalescer::forBlock<PointLightUBO>(std140::UploadCost{ 100.0, 1.0 });
+
+    const std::vector<std140::MemberRange> dirty =
+    {
+        { light8.offset + 2, 4 },               // inside light 8's location, grows to the whole vec3
+        { location1.offset, 4 },
+        { color1.offset + 12, 4 },              // only the padding after light 1's color, dropped
+        { color1.offset + 4, 4 },
+        { location1.offset + 12, 4 }            // the padding between location and color, dropped
+    };
+
+    const std::vector<std140::MemberRange> uploads = coalescer.coalesce(dirty);
+
+    bool passed = coalescer.maxGap() == 100 && uploads.size() == 2 &&
+        uploads[0].offset == location1.offset && uploads[0].size == color1.offset + color1.size - location1.offset &&
+        uploads[1].offset == light8.offset && uploads[1].size == 12;
+
+    coalescer.setMaxGap(0);
+    const std::vector<std140::MemberRange>& separate = coalescer.coalesce(dirty);
+
+    passed = passed && separate.size() == 3 && std140::uploadStats(separate).bytes == 36 && std140::uploadStats(uploads).bytes == 40;
+
+    std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+// diffs the light block against its shadow after writes through plain references, and a random byte buffer against a slot by slot memcmp
+void ShadowDiffTest()
+{
+    PointLightUBO lights{};
+    std140::Shadow<PointLightUBO> shadow;
+
+    const std::vector<std140::MemberRange> first = shadow.diff(lights);
+    bool passed = first.size() == 1 && first[0].offset == 0 && first[0].size == sizeof(PointLightUBO) && shadow.diff(lights).empty();
+
+    lights.nPointLights = 5;
+    lights.pointLights[3].location = { { 1.0f, 2.0f, 3.0f } };
+    lights.pointLights[3].color = { { 1.0f, 1.0f, 1.0f } };
+    lights.pointLights[4].color[1] = 0.5f;
+
+    const std::vector<std140::MemberRange> changed = shadow.diff(lights);
+
+    // light 3's location and color sit in neighbouring slots and come back as one range
+    passed = passed && changed.size() == 3 &&
+        changed[0].offset == 0 && changed[0].size == 16 &&
+        changed[1].offset == std140::offset_of<PointLightUBO>("pointLights[3].location") && changed[1].size == 32 &&
+        changed[2].offset == std140::offset_of<PointLightUBO>("pointLights[4].color") && changed[2].size == 16 &&
+        shadow.diff(lights).empty();
+
+    // 1000 bytes, not a multiple of 16 or 64, so the tail is compared too
+    std::vector<unsigned char> buffer(1000, 0);
+    std::vector<unsigned char> uploaded(buffer);
+    std140::ShadowImage image(buffer.size());
+    image.diff(buffer.data());
+
+    unsigned seed = 1;
+    for (int round = 0; round < 100 && passed; round++)
+    {
+        for (int writes = round % 7; writes > 0; writes--)
+        {
+            seed = seed * 1103515245u + 12345u;
+            buffer[(seed >> 8) % buffer.size()]++;
+        }
+
+        std::vector<std140::MemberRange> expected;
+        for (std::size_t offset = 0; offset < buffer.size(); offset += 16)
+        {
+            const std::size_t size = std::min<std::size_t>(16, buffer.size() - offset);
+
+            if (std::memcmp(buffer.data() + offset, uploaded.data() + offset, size) != 0)
+            {
+                if (!expected.empty() && expected.back().offset + expected.back().size == offset)
+                {
+                    expected.back().size += size;
+                }
+                else
+                {
+                    expected.push_back(std140::MemberRange{ offset, size });
+                }
+            }
+        }
+        uploaded = buffer;
+
+        const std::vector<std140::MemberRange>& ranges = image.diff(buffer.data());
+        passed = ranges.size() == expected.size();
+
+        for (std::size_t i = 0; i < ranges.size() && passed; i++)
+        {
+            passed = ranges[i].offset == expected[i].offset && ranges[i].size == expected[i].size;
+        }
+    }
+
+    passed = passed && std::memcmp(image.bytes(), buffer.data(), buffer.size()) == 0;
+
+    std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+// pushes light blocks through rings on the mock backend, checking no slot is reused before the GPU is done with it, then on a real buffer if GL 4.4 is there
+void UniformRingTest()
+{
+    bool passed = true;
+
+    // 4 KB holds 4 light blocks at 256 byte alignment, less than the 3 frames of 3 in flight, so it has to stall. 16 KB doesn't
+    const std::size_t ringSizes[2] = { 4096, 16384 };
+
+    for (std::size_t size : ringSizes)
+    {
+        std140::UniformRing<std140::MockRingBackend> ring(size, 256, 2);
+
+        struct Written
+        {
+            std140::MockRingBackend::Fence frame;
+            std::size_t offset;
+        };
+        std::deque<Written> inFlight;
+
+        for (int frame = 0; frame < 100 && passed; frame++)
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                PointLightUBO lights{};
+                lights.nPointLights = frame * 16 + i;
+
+                const auto slot = ring.push(lights);
+                passed = passed && slot.valid() && slot.offset % 256 == 0 && slot.offset + sizeof(PointLightUBO) <= size;
+
+                // the new slot can only take the place of blocks of frames the GPU has finished
+                while (!inFlight.empty() && inFlight.front().frame <= ring.backend().completed)
+                {
+                    inFlight.pop_front();
+                }
+
+                for (const Written& written : inFlight)
+                {
+                    passed = passed && (slot.offset >= written.offset + sizeof(PointLightUBO) || written.offset >= slot.offset + sizeof(PointLightUBO));
+                }
+
+                inFlight.push_back(Written{ std140::MockRingBackend::Fence(frame + 1), slot.offset });
+            }
+
+            ring.endFrame();
+        }
+
+        const std140::UniformRingStats& stats = ring.stats();
+        passed = passed && stats.frames == 100 && stats.allocations == 300 && stats.failed == 0 &&
+            (size == 4096 ? stats.stalls > 0 : stats.stalls == 0) && stats.stalls == ring.backend().waits;
+
+        struct Huge : public std140::UBOStruct<>
+        {
+            std140::Array<std140::vec4, 1024> values;
+        };
+
+        passed = passed && !ring.allocate<Huge>().valid() && ring.stats().failed == 1;
+    }
+
+    if (glBufferStorage)
+    {
+        std140::UniformRing<std140::GLRingBackend> ring(64 * 1024);
+
+        for (int frame = 0; frame < 8 && passed; frame++)
+        {
+            const auto slot = ring.push(PointLightUBO());
+            glBindBufferRange(GL_UNIFORM_BUFFER, 0, ring.backend().buffer(), GLintptr(slot.offset), sizeof(PointLightUBO));
+
+            passed = passed && slot.valid() && slot.offset % ring.backend().offsetAlignment() == 0;
+            ring.endFrame();
+        }
+
+        glBindBufferBase(GL_UNIFORM_BUFFER, 0, 0);
+        passed = passed && ring.backend().memory() != nullptr && glGetError() == GL_NO_ERROR;
+    }
+    else
+    {
+        std::cout << "no glBufferStorage, GLRingBackend not tested" << std::endl;
+    }
+
+    std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+// hands light blocks from a writer thread to this one, checking every frame acquired is whole and newer than the last
+void TripleBufferTest()
+{
+    std140::TripleBuffer<PointLightUBO> lights;
+
+    bool passed = !lights.acquire();
+
+    lights.write().nPointLights = 7;
+    lights.publish();
+
+    passed = passed && lights.acquire() && lights.read().nPointLights == 7 && !lights.acquire();
+
+    const std140::int32_t frames = 200000;
+
+    std::thread writer([&lights]()
+    {
+        for (std140::int32_t frame = 1; frame <= frames; frame++)
+        {
+            PointLightUBO& block = lights.write();
+            block.nPointLights = frame;
+
+            for (std::size_t i = 0; i < pbr_lights::MAX_POINT_LIGHTS; i++)
+            {
+                block.pointLights[i].location = { { float(frame), float(frame), float(frame) } };
+            }
+
+            lights.publish();
+        }
+    });
+
+    std140::int32_t last = 0;
+    std::size_t acquired = 0;
+
+    while (last < frames && passed)
+    {
+        if (!lights.acquire())
+        {
+            continue;
+        }
+
+        const PointLightUBO& block = lights.read();
+        passed = block.nPointLights > last;
+
+        for (std::size_t i = 0; i < pbr_lights::MAX_POINT_LIGHTS && passed; i++)
+        {
+            passed = block.pointLights[i].location[2] == float(block.nPointLights);
+        }
+
+        last = block.nPointLights;
+        acquired++;
+    }
+
+    writer.join();
+
+    if (verbose)
+    {
+        std::cout << acquired << " of " << frames << " frames acquired" << std::endl;
+    }
+
+    std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
+}
+
+// a fake program with one block { vec3 a; float b[2]; } and a loose uniform, counting the introspection calls made on it
+namespace MockReflection
+{
+    struct Uniform
+    {
+        const char* name;
+        GLint values[7];    // block index, offset, type, size, array stride, matrix stride, row major
+    };
+
+    const Uniform uniforms[] =
+    {
+        { "a", { 0, 0, GL_FLOAT_VEC3, 1, 0, 0, 0 } },
+        { "b[0]", { 0, 16, GL_FLOAT, 2, 16, 0, 0 } },
+        { "loose", { -1, -1, GL_FLOAT, 1, -1, -1, 0 } }
+    };
+
+    int calls = 0;
+
+    void APIENTRY GetProgramiv(GLuint, GLenum pname, GLint* params)
+    {
+        calls++;
+        *params = pname == GL_ACTIVE_UNIFORMS ? 3 : pname == GL_ACTIVE_UNIFORM_BLOCKS ? 1 : 16;
+    }
+
+    void APIENTRY GetActiveUniformsiv(GLuint, GLsizei count, const GLuint* indices, GLenum pname, GLint* params)
+    {
+        calls++;
+        const GLenum properties[] = { GL_UNIFORM_BLOCK_INDEX, GL_UNIFORM_OFFSET, GL_UNIFORM_TYPE, GL_UNIFORM_SIZE, GL_UNIFORM_ARRAY_STRIDE, GL_UNIFORM_MATRIX_STRIDE, GL_UNIFORM_IS_ROW_MAJOR };
+
+        for (int p = 0; p < 7; p++)
+        {
+            for (GLsizei i = 0; pname == properties[p] && i < count; i++)
+            {
+                params[i] = uniforms[indices[i]].values[p];
+            }
+        }
+    }
+
+    void APIENTRY GetActiveUniformName(GLuint, GLuint index, GLsizei bufSize, GLsizei* length, GLchar* name)
+    {
+        calls++;
+        *length = GLsizei(std::strlen(uniforms[index].name));
+        std::memcpy(name, uniforms[index].name, std::min<GLsizei>(*length + 1, bufSize));
+    }
+
+    void APIENTRY GetActiveUniformBlockiv(GLuint, GLuint, GLenum pname, GLint* params)
+    {
+        calls++;
+        *params = pname == GL_UNIFORM_BLOCK_DATA_SIZE ? 48 : 3;
+    }
+
+    void APIENTRY GetActiveUniformBlockName(GLuint, GLuint, GLsizei, GLsizei* length, GLchar* name)
+    {
+        calls++;
+        *length = 9;
+        std::memcpy(name, "MockBlock", 10);
+    }
+
+    const GLubyte* APIENTRY GetString(GLenum)
+    {
+        return reinterpret_cast<const GLubyte*>("mock driver");
+    }
+
+    const Virtuoso::GL::ReflectionGL gl = { GetProgramiv, GetActiveUniformsiv, GetActiveUniformName, GetActiveUniformBlockiv, GetActiveUniformBlockName, GetString };
+}
+
+// batched reflection of the mock program, its round trip through the cache, and the real program against the C++ offsets
+void ProgramReflectionTest(GLuint program)
+{
+    MockReflection::calls = 0;
+    const Virtuoso::GL::ProgramLayout mock = Virtuoso::GL::ReflectProgram(0, MockReflection::gl);
+
+    // 4 counts, 7 batched properties, 3 names, and a name and 2 properties for the block
+    const int coldCalls = MockReflection::calls;
+    bool passed = coldCalls == 4 + 7 + 3 + 3;
+
+    passed = passed && mock.blocks.size() == 1 && mock.blocks[0].name == "MockBlock" && mock.blocks[0].dataSize == 48 && mock.blocks[0].uniforms.size() == 2 &&
+        mock.uniforms.size() == 3 && mock.uniforms[1].name == "b[0]" && mock.uniforms[1].offset == 16 && mock.uniforms[1].arrayStride == 16 && mock.uniforms[2].blockIndex == -1;
+
+    const std::size_t key = Virtuoso::GL::ProgramSourceHash({ "mock vertex source", "mock fragment source" });
+
+    std::ostringstream cacheFile;
+    cacheFile << "./" << std::hex << key << ".layout";
+    std::remove(cacheFile.str().c_str());
+
+    Virtuoso::GL::ReflectProgramCached(0, key, ".", MockReflection::gl);
+
+    MockReflection::calls = 0;
+    const Virtuoso::GL::ProgramLayout warm = Virtuoso::GL::ReflectProgramCached(0, key, ".", MockReflection::gl);
+
+    // the warm start is read from the file without a single introspection call
+    passed = passed && MockReflection::calls == 0 && warm.uniforms.size() == mock.uniforms.size() && warm.blocks[0].uniforms == mock.blocks[0].uniforms &&
+        warm.uniforms[1].name == "b[0]" && warm.uniforms[1].arraySize == 2 && warm.uniforms[0].type == GL_FLOAT_VEC3;
+
+    std::remove(cacheFile.str().c_str());
+
+    const Virtuoso::GL::ProgramLayout real = Virtuoso::GL::ReflectProgram(program);
+
+    const std::size_t light = real.FindUniform("pointLights[0].color");
+    const std::size_t block = real.FindBlock("PointLightBlock");
+
+    passed = passed && light != Virtuoso::GL::ProgramLayout::npos && block != Virtuoso::GL::ProgramLayout::npos &&
+        real.uniforms[light].offset == GLint(offsetof(PointLightUBO, pointLights) + offsetof(PointLight, color)) && real.uniforms[light].blockIndex == GLint(block);
+
+    std::cout << "Test Result : " << (passed ? "PASSED" : "FAILED") << std::endl;
+
+    if (!passed || verbose)
+    {
+        std::cout << "mock program : " << coldCalls << " introspection calls cold, " << MockReflection::calls << " warm" << std::endl;
+        std::cout << "real program : " << real.uniforms.size() << " uniforms in " << real.blocks.size() << " blocks" << std::endl;
+    }
+}
+
+int main(void)
+{
+    glfw::Window::Hints hnts;
+    glfw::Window wind(640, 480, hnts, "std140 Unit Test");
+
+    wind.MakeContextCurrent();
+
+    if (!gladLoadGLLoader((GLADloadproc)glfwGetProcAddress))
+    {
+        std::cout << "Failed to initialize GLAD" << std::endl;
+        return -1;
+    }
+ 
+    const GLubyte* vendorStr = glGetString(GL_RENDERER);
+
+    std::cout << "OpenGL Renderer : " << vendorStr << std::endl;
+    {
+        gl::Program bunnyProg(
+            Virtuoso::GL::Program(
+                {
+                    Virtuoso::GL::Shader(GL_VERTEX_SHADER, bunnyVert),
+                    Virtuoso::GL::Shader(GL_FRAGMENT_SHADER, bunnyFrag)
+                }
+        ));
+
+        std::cout << "sizeof(vec3) : " << sizeof(std140::vec3) << std::endl;
+        std::cout << "Align of vec4 " << alignof(std140::vec4) << std::endl;
+        std::cout << "Size of float[4] in glsl ubo std140 : " << sizeof(std140::Array<std140::ArrayAlignment<GLfloat>::ArrayAlignedType, 4>) << std::endl;
+        std::cout << "Size of vec2[4] in glsl ubo std140 : " << sizeof(std140::Array<std140::ArrayAlignment<std140::vec2>::ArrayAlignedType, 4>) << std::endl;
+        std::cout << "Alignment of array aligned float " << alignof(std140::ArrayAlignment<GLfloat>::ArrayAlignedType) << std::endl;
+
+        int tn = 1;
+        const int totalTests = 28;
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        TestStruct::uboOffsetTest(bunnyProg.name());
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        TestStruct2::uboOffsetTest(bunnyProg.name());
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        TestStruct3::uboOffsetTest(bunnyProg.name());
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        TestStruct3::uboOffsetTest2(bunnyProg.name());
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        TestStruct4::uboOffsetTest(bunnyProg.name());
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        TestStruct5::uboOffsetTest(bunnyProg.name());
+
+        std::cout << std140::ArrayAlignment<GLfloat>::AlignmentValue << std::endl;
+
+
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        TestStruct6::uboOffsetTest(bunnyProg.name());
+
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        ActualAppTest(bunnyProg.name());
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        TestMatrixStruct::uboOffsetTest(bunnyProg.name());
+
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        TestDoubleStruct::uboOffsetTest(bunnyProg.name());
+
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        TestDoubleStruct2::uboOffsetTest(bunnyProg.name());
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        TestStd430Block::ssboOffsetTest(bunnyProg.name());
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        RuntimeArrayTest(bunnyProg.name());
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        TranscodeTest();
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        InstanceAttributeTest(bunnyProg.name());
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        Vec4PackTest();
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        TestBoolStruct::uboOffsetTest(bunnyProg.name());
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        ReflectionTest<TestMatrixStruct>(bunnyProg.name(), "matStruct");
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        ReflectionTest<TestBoolStruct>(bunnyProg.name(), "boolStruct");
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        EmitterTest();
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        DynamicLayoutTest();
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        LayoutMigrationTest();
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        TrackedTest();
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        RangeCoalescerTest();
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        ShadowDiffTest();
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        UniformRingTest();
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        TripleBufferTest();
+
+        std::cout << "\n\nTEST " << tn++ << " of " << totalTests << std::endl;
+        ProgramReflectionTest(bunnyProg.name());
     }
 
     return 0;
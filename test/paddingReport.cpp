@@ -0,0 +1,10 @@
+// the blocks of the PBR demo, for the padding_report target. Upload counts are per frame
+
+#include <glad/glad.h>
+
+#include "../PaddingReport.h"
+#include "pbr_lights.glsl.h"
+
+STD140_PADDING_REPORT(pbr_lights::PointLightBlock, 1)
+STD140_PADDING_REPORT(pbr_lights::DirectionalLightBlock, 1)
+STD140_PADDING_REPORT(pbr_lights::SphereInstances, 1)
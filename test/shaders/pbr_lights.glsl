@@ -0,0 +1,43 @@
+// the light and material blocks of the PBR demo application.
+// test/main.cpp gets its C++ side from the header glsl2std140 generates from this file
+
+struct PointLight
+{
+    vec3 location;
+    vec3 color;
+};
+
+struct DirectionalLight
+{
+    vec3 direction;
+    vec3 color;
+};
+
+#define MAX_DIRECTIONAL_LIGHTS 25
+#define MAX_POINT_LIGHTS 25
+#define MAX_SPHERES 144
+
+layout(std140) uniform PointLightBlock
+{
+    int nPointLights;
+    PointLight       pointLights[MAX_POINT_LIGHTS];
+};
+
+layout(std140) uniform DirectionalLightBlock
+{
+    int nDirectionalLights;
+    DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHTS];
+};
+
+struct InstanceMaterial
+{
+    vec3  surfaceColor;
+    float roughness;
+    vec3  emissive;
+    float metallic;
+};
+
+layout(std140) uniform SphereInstances
+{
+   InstanceMaterial instanceMaterials[MAX_SPHERES];
+};
@@ -42,7 +42,7 @@ void main()
 )STRING";
 
 
-const std::string bunnyFrag =
+const char bunnyFragHeader[] =
 
 R"STRING(
 
@@ -57,46 +57,13 @@ flat in int instanceID;
 
 out vec4 col;
 
-struct PointLight
-{
-    vec3 location;
-    vec3 color;
-};
-
-struct DirectionalLight
-{
-    vec3 direction;
-    vec3 color;
-};
-
-#define MAX_DIRECTIONAL_LIGHTS 25
-#define MAX_POINT_LIGHTS 25
-#define MAX_SPHERES 144
-
-layout(std140) uniform PointLightBlock
-{
-    int nPointLights;
-    PointLight       pointLights[MAX_POINT_LIGHTS];
-};
-
-layout(std140) uniform DirectionalLightBlock
-{
-    int nDirectionalLights;
-    DirectionalLight directionalLights[MAX_DIRECTIONAL_LIGHTS];
-};
+)STRING";
 
-struct InstanceMaterial
-{
-    vec3  surfaceColor;
-    float roughness;
-    vec3  emissive;
-    float metallic;
-};
+// constexpr so GlslBlockParser.h can check the block layouts at compile time.
+// The light and material blocks come from shaders/pbr_lights.glsl, see bunnyFrag below
+constexpr char bunnyFragSource[] =
 
-layout(std140) uniform SphereInstances
-{
-   InstanceMaterial instanceMaterials[MAX_SPHERES];
-};
+R"STRING(
 
 struct TestStruct
 {
@@ -218,6 +185,47 @@ layout (std140) uniform DoubleUBO2
 };
 
 
+struct BoolStruct
+{
+    bool a;
+    bvec3 b;
+    bool c[2];
+    bvec2 d;
+};
+
+layout (std140) uniform BoolUBO
+{
+    BoolStruct boolStruct;
+};
+
+
+struct Std430Struct
+{
+    float a;
+    vec2 b;
+    float c[3];
+    vec3 d;
+    float e;
+    vec2 f[2];
+    mat2 g;
+    mat3 h;
+};
+
+layout (std430) buffer Std430Block
+{
+    float std430Floats[5];
+    vec2 std430Vec2s[3];
+    Std430Struct std430Struct;
+    float std430Tail;
+};
+
+layout (std430) buffer RuntimeArrayBlock
+{
+    int nRuntimeStructs;
+    Std430Struct runtimeStructs[];
+};
+
+
 void main(void)
 {
 // this is gibberish - just do a bunch of things that read the UBOs so that the compiler doesn't optimize them out.
@@ -232,7 +240,14 @@ void main(void)
     accum.xyz *= matStruct.a * instanceMaterials[0].surfaceColor;
     accum.xyz += testDoubleStruct[0].b;
     accum.xy += testDoubleStruct2[0].a;
+    accum.x += std430Floats[0] * std430Tail * std430Struct.a * std430Struct.c[0] * std430Struct.e;
+    accum.xy += std430Vec2s[0] + std430Struct.b + std430Struct.f[0] + std430Struct.g[0];
+    accum.xyz += std430Struct.d + std430Struct.h[0];
+    accum.x += runtimeStructs[nRuntimeStructs - 1].a;
+    accum.x += (boolStruct.a && boolStruct.b.z && boolStruct.c[1] && boolStruct.d.y) ? 1.0 : 0.0;
     col = accum;
 }
 
-)STRING";
\ No newline at end of file
+)STRING";
+
+const std::string bunnyFrag = std::string(bunnyFragHeader) + pbr_lights::glslSource + bunnyFragSource;
\ No newline at end of file
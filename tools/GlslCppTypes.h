@@ -0,0 +1,76 @@
+#pragma once
+#include "../GlslBlockParser.h"
+
+#include <string>
+
+/// C++ spellings of parsed GLSL member types, shared by the tools that write C++ declarations.
+/// prefix is "typename L::" inside the struct templates over the layout, or the layout namespace ("std140::") in blocks.
+/// layout is the template argument given to struct member types, "L" or "std140::Layout"
+
+namespace std140
+{
+    /// C++ type of a field, without the array
+    template <typename Shader>
+    std::string cppValueType(const Shader& shader, const GlslField& field, const std::string& prefix, const std::string& layout)
+    {
+        const GlslType& type = field.type;
+
+        switch (type.kind)
+        {
+        case GlslTypeKind::Struct:
+            return std::string(shader.structs[type.structIndex].name) + "<" + layout + ">";
+
+        case GlslTypeKind::Matrix:
+        {
+            const char* component = type.componentSize == 8 ? "double" : "float";
+
+            if (field.rowMajor)
+            {
+                return (prefix == "typename L::" ? "typename L::template " : prefix) + "Matrix<" + component + ", " +
+                    std::to_string(type.columns) + ", " + std::to_string(type.rows) + ", false>";
+            }
+
+            std::string name = std::string(type.componentSize == 8 ? "dmat" : "mat") + std::to_string(type.columns);
+            if (type.rows != type.columns)
+            {
+                name += "x" + std::to_string(type.rows);
+            }
+            return prefix + name;
+        }
+
+        case GlslTypeKind::Vector:
+            return prefix + std::string(field.typeName);
+
+        default:
+            if (field.typeName == "float")
+            {
+                return prefix + "float32_t";
+            }
+            if (field.typeName == "double")
+            {
+                return prefix + "double64_t";
+            }
+            if (field.typeName == "bool")
+            {
+                return prefix + "bool32_t";
+            }
+            return prefix + std::string(field.typeName) + "32_t";
+        }
+    }
+
+    /// C++ type of a field, as an Array<> if it is one, with the length spelled with its #define when it was given with one
+    template <typename Shader>
+    std::string cppFieldType(const Shader& shader, const GlslField& field, const std::string& prefix, const std::string& layout)
+    {
+        const std::string value = cppValueType(shader, field, prefix, layout);
+
+        if (!field.arrayLength)
+        {
+            return value;
+        }
+
+        const std::string length = field.arrayLengthName.empty() ? std::to_string(field.arrayLength) : std::string(field.arrayLengthName);
+
+        return (prefix == "typename L::" ? "typename L::template " : prefix) + "Array<" + value + ", " + length + ">";
+    }
+}
@@ -0,0 +1,285 @@
+/// glsl2std140 : generates a C++ header of Std140.h structs from the struct and block declarations of a GLSL source file
+///
+///     glsl2std140 <input.glsl> <output.h> [namespace]
+///
+/// For lights.glsl the header declares, in namespace lights (or the one given) :
+///     a const std::size_t for every #define NAME <integer>, so array lengths are shared with the shader
+///     every GLSL struct as a template over the layout (see std140::Layout), eg. PointLight<std140::Layout>, or PointLight<> for std140
+///     every std140 / std430 block as a struct of that layout, named after the block. A buffer block ending in an unsized array
+///     becomes a <Block>Header struct and a RuntimeArray typedef
+///     UBO_MEMBERS for all of them, so they come with reflection tables
+///     every member value-initialized with {}, so a default constructed block uploads zeros rather than garbage
+///     the GLSL source itself as constexpr char glslSource[], for building the shader and for static_assert checks with GlslBlockParser.h
+///
+/// The output is only written when it changes, so regenerating an untouched shader doesn't rebuild everything that includes it.
+/// The build tracks the run with a stamp file instead (see std140_generate_headers), since the header can stay older than the shader.
+/// One file per invocation, so the build runs them in parallel and only for the shaders that changed.
+
+// the headers only need the GL typedefs, nothing is called
+#include <glad/glad.h>
+
+#include "GlslCppTypes.h"
+
+#include <cctype>
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+
+namespace
+{
+    // generous capacities, the shader is parsed on the heap
+    typedef std140::BasicGlslShader<8192, 512, 512, 1024> ToolShader;
+
+    // MSVC limits a single string literal piece to 16K
+    const std::size_t MaxLiteralPiece = 8192;
+
+    bool readFile(const std::string& path, std::string& contents)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+
+        std::ostringstream stream;
+        stream << file.rdbuf();
+        contents = stream.str();
+        return true;
+    }
+
+    std::string identifierFromPath(const std::string& path)
+    {
+        std::string name = path.substr(path.find_last_of("/\\") + 1);
+        name = name.substr(0, name.find('.'));
+
+        for (char& c : name)
+        {
+            if (!std::isalnum(static_cast<unsigned char>(c)))
+            {
+                c = '_';
+            }
+        }
+
+        if (name.empty() || std::isdigit(static_cast<unsigned char>(name[0])))
+        {
+            name = "_" + name;
+        }
+
+        return name;
+    }
+
+    class HeaderWriter
+    {
+    public:
+
+        HeaderWriter(const ToolShader& shader) : shader(shader)
+        {
+        }
+
+        bool members(std::ostream& out, const char* typeName, std::size_t first, std::size_t count, const std::string& prefix, const std::string& layout, std::string& error) const
+        {
+            for (std::size_t i = first; i < first + count; i++)
+            {
+                out << "        " << std140::cppFieldType(shader, shader.fields[i], prefix, layout) << " " << shader.fields[i].name << "{};\n";
+            }
+
+            if (count > 32)
+            {
+                error = std::string(typeName) + " has more than the 32 members UBO_MEMBERS can list";
+                return false;
+            }
+
+            if (count)
+            {
+                out << "\n        UBO_MEMBERS(" << typeName;
+                for (std::size_t i = first; i < first + count; i++)
+                {
+                    out << ", " << shader.fields[i].name;
+                }
+                out << ")\n";
+            }
+
+            return true;
+        }
+
+        bool write(std::ostream& out, const std::string& source, const std::string& inputName, const std::string& namespaceName, std::string& error) const
+        {
+            out << "// Generated by glsl2std140 from " << inputName << ", do not edit\n";
+            out << "#pragma once\n";
+            out << "#include \"Std140.h\"\n";
+            out << "#include \"Std430.h\"\n";
+            out << "#include \"UBOMembers.h\"\n\n";
+            out << "namespace " << namespaceName << "\n{\n";
+
+            for (std::size_t i = 0; i < shader.defineCount; i++)
+            {
+                const std140::GlslDefine& define = shader.defines[i];
+
+                if (define.value >= 0)
+                {
+                    out << "    const std::size_t " << define.name << " = " << define.value << "u;\n";
+                }
+                else
+                {
+                    out << "    const long long " << define.name << " = " << define.value << ";\n";
+                }
+            }
+
+            if (shader.defineCount)
+            {
+                out << "\n";
+            }
+
+            for (std::size_t s = 0; s < shader.structCount; s++)
+            {
+                const std140::GlslStruct& decl = shader.structs[s];
+                const std::string name(decl.name);
+
+                out << "    template <typename L = std140::Layout>\n";
+                out << "    struct " << name << " : public L::template UBOStruct<>\n    {\n";
+
+                if (!members(out, name.c_str(), decl.firstField, decl.fieldCount, "typename L::", "L", error))
+                {
+                    return false;
+                }
+
+                out << "    };\n\n";
+            }
+
+            for (std::size_t b = 0; b < shader.blockCount; b++)
+            {
+                const std140::GlslBlock& block = shader.blocks[b];
+
+                if (block.layout == std140::GlslLayout::Other)
+                {
+                    out << "    // " << block.name << " has no std140 or std430 layout qualifier, its offsets are up to the driver\n\n";
+                    continue;
+                }
+
+                const std::string layoutNamespace = block.layout == std140::GlslLayout::Std140 ? "std140" : "std430";
+                const std::string name(block.name);
+
+                std::size_t count = block.fieldCount;
+                const bool runtimeSized = count && shader.fields[block.firstField + count - 1].runtimeSized;
+
+                if (runtimeSized)
+                {
+                    count--;
+                }
+
+                const std::string structName = runtimeSized ? name + "Header" : name;
+
+                out << "    struct " << structName << "\n    {\n";
+
+                if (!members(out, structName.c_str(), block.firstField, count, layoutNamespace + "::", layoutNamespace + "::Layout", error))
+                {
+                    return false;
+                }
+
+                out << "    };\n";
+
+                if (runtimeSized)
+                {
+                    const std140::GlslField& tail = shader.fields[block.firstField + count];
+
+                    out << "\n    // " << tail.name << "[] starts at offset " << tail.offset[block.layout == std140::GlslLayout::Std140 ? 0 : 1] << "\n";
+                    out << "    typedef " << layoutNamespace << "::RuntimeArray<" << (count ? structName : layoutNamespace + "::NoHeader") << ", "
+                        << std140::cppValueType(shader, tail, layoutNamespace + "::", layoutNamespace + "::Layout") << "> " << name << ";\n";
+                }
+
+                out << "\n";
+            }
+
+            out << "    constexpr char glslSource[] =\n";
+
+            for (std::size_t start = 0; start < source.size();)
+            {
+                std::size_t end = start + MaxLiteralPiece;
+
+                if (end >= source.size())
+                {
+                    end = source.size();
+                }
+                else
+                {
+                    const std::size_t newline = source.rfind('\n', end);
+                    end = (newline != std::string::npos && newline > start) ? newline + 1 : end;
+                }
+
+                out << "R\"GLSL(" << source.substr(start, end - start) << ")GLSL\"\n";
+                start = end;
+            }
+
+            out << "    ;\n}\n";
+
+            return true;
+        }
+
+    private:
+
+        const ToolShader& shader;
+    };
+}
+
+int main(int argc, char** argv)
+{
+    if (argc < 3)
+    {
+        std::cerr << "usage : glsl2std140 <input.glsl> <output.h> [namespace]" << std::endl;
+        return 1;
+    }
+
+    const std::string inputPath = argv[1];
+    const std::string outputPath = argv[2];
+    const std::string namespaceName = argc > 3 ? argv[3] : identifierFromPath(inputPath);
+
+    std::string source;
+    if (!readFile(inputPath, source))
+    {
+        std::cerr << inputPath << " : error : can't read the file" << std::endl;
+        return 1;
+    }
+
+    if (source.find(")GLSL\"") != std::string::npos)
+    {
+        std::cerr << inputPath << " : error : the source contains the raw string delimiter )GLSL\"" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<ToolShader> shader(new ToolShader());
+    std140::parseGlsl(source, *shader);
+
+    if (!shader->ok())
+    {
+        std::cerr << inputPath << "(" << shader->errorLine << ") : error : " << shader->error << std::endl;
+        return 1;
+    }
+
+    std::ostringstream header;
+    std::string error;
+
+    if (!HeaderWriter(*shader).write(header, source, inputPath.substr(inputPath.find_last_of("/\\") + 1), namespaceName, error))
+    {
+        std::cerr << inputPath << " : error : " << error << std::endl;
+        return 1;
+    }
+
+    std::string existing;
+    if (readFile(outputPath, existing) && existing == header.str())
+    {
+        return 0;
+    }
+
+    std::ofstream output(outputPath, std::ios::binary);
+    output << header.str();
+
+    if (!output)
+    {
+        std::cerr << outputPath << " : error : can't write the file" << std::endl;
+        return 1;
+    }
+
+    return 0;
+}
@@ -0,0 +1,221 @@
+/// std140plan : finds the member orders that minimize the padding of the structs and blocks of a GLSL file, see LayoutPlanner.h
+///
+///     std140plan [--std430] [--check] <input.glsl> [name ...]
+///
+/// Every struct and std140 / std430 block (or only the ones named) is planned, and for each one that can shrink
+/// the reordered GLSL declaration and the matching C++ declaration (in the form glsl2std140 generates) are printed.
+/// Structs are planned with the std140 rules, or std430 with --std430. Blocks use their own layout.
+/// With --check the exit code is 1 if anything can shrink, so a build can keep the shaders packed.
+
+// the headers only need the GL typedefs, nothing is called
+#include <glad/glad.h>
+
+#include "GlslCppTypes.h"
+#include "../LayoutPlanner.h"
+
+#include <fstream>
+#include <iostream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+
+namespace
+{
+    typedef std140::BasicGlslShader<8192, 512, 512, 1024> ToolShader;
+
+    bool readFile(const std::string& path, std::string& contents)
+    {
+        std::ifstream file(path, std::ios::binary);
+        if (!file)
+        {
+            return false;
+        }
+
+        std::ostringstream stream;
+        stream << file.rdbuf();
+        contents = stream.str();
+        return true;
+    }
+
+    std::string glslMember(const std140::GlslField& field)
+    {
+        std::string declaration = "    ";
+
+        if (field.type.kind == std140::GlslTypeKind::Matrix && field.rowMajor)
+        {
+            declaration += "layout(row_major) ";
+        }
+
+        declaration += std::string(field.typeName) + " " + std::string(field.name);
+
+        if (field.runtimeSized)
+        {
+            declaration += "[]";
+        }
+        else if (field.arrayLength)
+        {
+            declaration += "[" + (field.arrayLengthName.empty() ? std::to_string(field.arrayLength) : std::string(field.arrayLengthName)) + "]";
+        }
+
+        return declaration + ";\n";
+    }
+
+    /// Prints the planned declaration of the struct or block at [first, first + count), returns false if there's nothing to gain
+    bool printPlan(const ToolShader& shader, const std::string& name, std::size_t first, const std140::LayoutPlan& plan,
+        const std::string& glslHead, const std::string& glslTail, const std::string& cppHead, const std::string& prefix, const std::string& layout)
+    {
+        if (!plan.count)
+        {
+            std::cout << "// " << name << " : not planned, it has no std140 / std430 layout or more than " << std140::MaxPlannedMembers << " members\n\n";
+            return false;
+        }
+
+        const char* note = plan.exhaustive ? "" : " (the search ran out of budget, a better order may exist)";
+
+        if (!plan.savedBytes())
+        {
+            std::cout << "// " << name << " : " << plan.size << " bytes, already packed" << note << "\n\n";
+            return false;
+        }
+
+        std::cout << "// " << name << " : " << plan.originalSize << " -> " << plan.size << " bytes, saves " << plan.savedBytes() << note << "\n";
+
+        std::cout << glslHead << "\n{\n";
+        for (std::size_t i = 0; i < plan.count; i++)
+        {
+            std::cout << glslMember(shader.fields[first + plan.order[i]]);
+        }
+        std::cout << "}" << glslTail << ";\n\n";
+
+        std::cout << cppHead << "\n{\n";
+
+        std::string members;
+        for (std::size_t i = 0; i < plan.count; i++)
+        {
+            const std140::GlslField& field = shader.fields[first + plan.order[i]];
+
+            if (field.runtimeSized)
+            {
+                std::cout << "    // " << std140::cppValueType(shader, field, prefix, layout) << " " << field.name << "[] follows, see RuntimeArray\n";
+                continue;
+            }
+
+            std::cout << "    " << std140::cppFieldType(shader, field, prefix, layout) << " " << field.name << ";\n";
+            members += ", " + std::string(field.name);
+        }
+
+        std::cout << "\n    UBO_MEMBERS(" << name << members << ")\n};\n\n";
+
+        return true;
+    }
+
+    bool wanted(const std::vector<std::string>& names, std::string_view name)
+    {
+        if (names.empty())
+        {
+            return true;
+        }
+
+        for (const std::string& n : names)
+        {
+            if (n == name)
+            {
+                return true;
+            }
+        }
+        return false;
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std140::GlslLayout structLayout = std140::GlslLayout::Std140;
+    bool check = false;
+    std::string inputPath;
+    std::vector<std::string> names;
+
+    for (int i = 1; i < argc; i++)
+    {
+        const std::string arg = argv[i];
+
+        if (arg == "--std430")
+        {
+            structLayout = std140::GlslLayout::Std430;
+        }
+        else if (arg == "--check")
+        {
+            check = true;
+        }
+        else if (inputPath.empty())
+        {
+            inputPath = arg;
+        }
+        else
+        {
+            names.push_back(arg);
+        }
+    }
+
+    if (inputPath.empty())
+    {
+        std::cerr << "usage : std140plan [--std430] [--check] <input.glsl> [name ...]" << std::endl;
+        return 1;
+    }
+
+    std::string source;
+    if (!readFile(inputPath, source))
+    {
+        std::cerr << inputPath << " : error : can't read the file" << std::endl;
+        return 1;
+    }
+
+    std::unique_ptr<ToolShader> shader(new ToolShader());
+    std140::parseGlsl(source, *shader);
+
+    if (!shader->ok())
+    {
+        std::cerr << inputPath << "(" << shader->errorLine << ") : error : " << shader->error << std::endl;
+        return 1;
+    }
+
+    bool shrinks = false;
+
+    for (std::size_t s = 0; s < shader->structCount; s++)
+    {
+        const std140::GlslStruct& decl = shader->structs[s];
+
+        if (!wanted(names, decl.name))
+        {
+            continue;
+        }
+
+        const std::string name(decl.name);
+        const std140::LayoutPlan plan = std140::planLayout(*shader, decl.name, structLayout);
+
+        shrinks = printPlan(*shader, name, decl.firstField, plan, "struct " + name, "",
+            "template <typename L = " + std::string(structLayout == std140::GlslLayout::Std140 ? "std140" : "std430") + "::Layout>\nstruct " + name + " : public L::template UBOStruct<>",
+            "typename L::", "L") || shrinks;
+    }
+
+    for (std::size_t b = 0; b < shader->blockCount; b++)
+    {
+        const std140::GlslBlock& block = shader->blocks[b];
+
+        if (!wanted(names, block.name))
+        {
+            continue;
+        }
+
+        const std::string name(block.name);
+        const std::string layoutNamespace = block.layout == std140::GlslLayout::Std140 ? "std140" : "std430";
+        const std140::LayoutPlan plan = std140::planLayout(*shader, block.name);
+
+        shrinks = printPlan(*shader, name, block.firstField, plan,
+            "layout(" + layoutNamespace + ") " + (block.buffer ? "buffer " : "uniform ") + name,
+            block.instanceName.empty() ? "" : " " + std::string(block.instanceName),
+            "struct " + name, layoutNamespace + "::", layoutNamespace + "::Layout") || shrinks;
+    }
+
+    return (check && shrinks) ? 1 : 0;
+}
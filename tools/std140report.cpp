@@ -0,0 +1,29 @@
+/// std140report : prints the padding report of the blocks registered with STD140_PADDING_REPORT, see PaddingReport.h
+///
+///     std140report [worst]
+///
+/// This is only the main(). Link it with the .cpp files that register a codebase's blocks, as CMakeLists.txt does
+/// for the test blocks in test/paddingReport.cpp, and it lists the [worst] (default 20) members by padding uploaded per frame.
+
+// the headers only need the GL typedefs, nothing is called
+#include <glad/glad.h>
+
+#include "../PaddingReport.h"
+
+#include <cstdlib>
+#include <iostream>
+
+int main(int argc, char** argv)
+{
+    const std::size_t worst = argc > 1 ? std::strtoul(argv[1], nullptr, 10) : 20;
+
+    if (std140::paddingRegistry().empty())
+    {
+        std::cerr << "std140report : no blocks registered, link in the files using STD140_PADDING_REPORT" << std::endl;
+        return 1;
+    }
+
+    std140::printPaddingReport(std::cout, worst);
+
+    return 0;
+}